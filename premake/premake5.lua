@@ -37,6 +37,15 @@ project "lib"
 	targetname("iplayerlib")
 	files {path.join(Root, "src/lib/**.*")}
 
+project "trackconverter"
+	kind "ConsoleApp"
+	cppdialect "C++20"
+
+	targetname("trackconverter")
+	files { path.join(Root, "tools/trackconverter/**.*") }
+	includedirs { path.join(Root, "src/lib") }
+	links { "lib" }
+
 project "test"
 	kind "ConsoleApp"
 	cppdialect "C++20"
@@ -1,10 +1,42 @@
+#include "headercache.h"
+#include "outputmultiplexer.h"
 #include "shell.h"
 #include "threadmusicplayer.h"
 
+#include <iostream>
+#include <string_view>
+
 int main(int argc, char* argv[])
 {
-	auto musicPlayer = std::make_shared<iplayer::ThreadMusicPlayer>(std::cout);
-	auto player = std::make_shared<iplayer::Player>(musicPlayer, iplayer::Playlist{});
-	iplayer::Shell shell{player, std::cin, std::cout};
-	shell.run();
+	auto headerCacheFile = iplayer::HeaderCache::defaultFile();
+	for (int i = 1; i != argc; ++i) {
+		if (std::string_view(argv[i]) == "--header-cache" && i + 1 != argc) {
+			headerCacheFile = argv[++i];
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--header-cache <file>]\n";
+			return 1;
+		}
+	}
+	if (!headerCacheFile.empty()) {
+		iplayer::HeaderCache::global().open(headerCacheFile);
+	}
+
+	{
+		// One stream by writing thread, all written to std::cout without interleaving.
+		using Policy = iplayer::OutputMultiplexer::OverflowPolicy;
+		iplayer::OutputMultiplexer output(std::cout);
+		const auto shellOs = output.createStream(Policy::Block);
+		const auto eventOs = output.createStream(Policy::Block);
+		const auto lyricsOs = output.createStream(Policy::Drop); // never stall playback
+		std::cin.tie(shellOs.get()); // show the prompt before reading
+
+		auto musicPlayer =
+			std::make_shared<iplayer::ThreadMusicPlayer>(*lyricsOs, iplayer::TrackLoading::Streaming);
+		auto player = std::make_shared<iplayer::Player>(musicPlayer, iplayer::Playlist{});
+		iplayer::Shell shell{player, std::cin, *shellOs, *eventOs};
+		shell.run();
+		std::cin.tie(&std::cout);
+	}
+
+	iplayer::HeaderCache::global().save();
 }
@@ -0,0 +1,165 @@
+#include "binarytrack.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+
+struct FileHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::int64_t duration; // in seconds
+	std::uint32_t titleSize;
+	std::uint32_t metadataSize;
+	std::uint64_t lineCount;
+};
+
+//------------------------------------------------------------------------------
+std::size_t alignUp(std::size_t n)
+{
+	return (n + 7) & ~std::size_t(7);
+}
+
+//------------------------------------------------------------------------------
+std::uint64_t readOffset(const char* offsets, std::size_t i)
+{
+	std::uint64_t res;
+	std::memcpy(&res, offsets + i * sizeof(res), sizeof(res));
+	return res;
+}
+
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+bool BinaryTrack::hasMagic(std::string_view content)
+{
+	return content.size() >= sizeof(magic) && std::memcmp(content.data(), magic, sizeof(magic)) == 0;
+}
+
+//------------------------------------------------------------------------------
+BinaryTrack::BinaryTrack(const std::filesystem::path& path) : file(path)
+{
+	const auto data = file.data();
+	FileHeader header;
+	if (!file.isOpen() || data.size() < sizeof(header) || !hasMagic(data)) {
+		return;
+	}
+	std::memcpy(&header, data.data(), sizeof(header));
+	const auto tableOffset = alignUp(sizeof(header) + header.titleSize + header.metadataSize);
+	if (header.version != version || data.size() < tableOffset
+	    || (data.size() - tableOffset) / sizeof(std::uint64_t) <= header.lineCount) {
+		return;
+	}
+	const auto payloadOffset = tableOffset + (header.lineCount + 1) * sizeof(std::uint64_t);
+	title = data.substr(sizeof(header), header.titleSize);
+	metadata = data.substr(sizeof(header) + header.titleSize, header.metadataSize);
+	duration = std::chrono::seconds(header.duration);
+	lineCount = header.lineCount;
+	offsets = data.data() + tableOffset;
+	payload = data.substr(payloadOffset);
+	// Only the end is checked, other offsets are checked on access.
+	valid = readOffset(offsets, lineCount) <= payload.size();
+}
+
+//------------------------------------------------------------------------------
+std::string_view BinaryTrack::getLine(std::size_t n) const
+{
+	if (lineCount <= n) {
+		return {};
+	}
+	const auto begin = readOffset(offsets, n);
+	const auto end = readOffset(offsets, n + 1);
+	if (end < begin || payload.size() < end) {
+		return {};
+	}
+	return payload.substr(begin, end - begin);
+}
+
+//------------------------------------------------------------------------------
+void writeBinaryTrack(std::ostream& os,
+                      std::string_view title,
+                      std::chrono::seconds duration,
+                      std::string_view metadata,
+                      const std::vector<std::string>& lines)
+{
+	FileHeader header{};
+	std::memcpy(header.magic, BinaryTrack::magic, sizeof(header.magic));
+	header.version = BinaryTrack::version;
+	header.duration = duration.count();
+	header.titleSize = static_cast<std::uint32_t>(title.size());
+	header.metadataSize = static_cast<std::uint32_t>(metadata.size());
+	header.lineCount = lines.size();
+
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	os.write(title.data(), title.size());
+	os.write(metadata.data(), metadata.size());
+	const auto size = sizeof(header) + title.size() + metadata.size();
+	const char padding[8]{};
+	os.write(padding, alignUp(size) - size);
+	std::uint64_t offset = 0;
+	os.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+	for (const auto& line : lines) {
+		offset += line.size();
+		os.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+	}
+	for (const auto& line : lines) {
+		os.write(line.data(), line.size());
+	}
+}
+
+//------------------------------------------------------------------------------
+bool convertTrack(const std::filesystem::path& from,
+                  const std::filesystem::path& to,
+                  TrackFormat format)
+{
+	std::string title;
+	std::chrono::seconds duration;
+	std::string metadata;
+	std::vector<std::string> lines;
+
+	if (BinaryTrack track(from); track.isOpen()) {
+		title = track.getTitle();
+		duration = track.getDuration();
+		metadata = track.getMetadata();
+		lines.reserve(track.getLineCount());
+		for (std::size_t i = 0; i != track.getLineCount(); ++i) {
+			lines.emplace_back(track.getLine(i));
+		}
+	} else {
+		std::ifstream file(from, std::ios::binary);
+		std::string line;
+		if (!std::getline(file, line) || BinaryTrack::hasMagic(line)) {
+			return false;
+		}
+		std::istringstream ss(line);
+		int seconds = 0;
+		if (!(ss >> std::quoted(title) >> seconds)) {
+			return false;
+		}
+		duration = std::chrono::seconds(seconds);
+		std::getline(ss, metadata); // keep separators as is
+		while (std::getline(file, line)) {
+			lines.push_back(std::move(line));
+		}
+	}
+
+	std::ofstream os(to, std::ios::binary);
+	if (format == TrackFormat::Binary) {
+		writeBinaryTrack(os, title, duration, metadata, lines);
+	} else {
+		os << std::quoted(title) << ' ' << duration.count() << metadata << '\n';
+		for (const auto& line : lines) {
+			os << line << '\n';
+		}
+	}
+	return static_cast<bool>(os.flush());
+}
+
+} // namespace iplayer
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "mappedfile.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iplayer
+{
+
+/* Binary track file, in native endianness:
+   - fixed header (magic, version, duration, sizes),
+   - title and raw metadata (as after the duration in the text header line),
+   - line-offset table (lineCount + 1 offsets, 8-byte aligned, relative to the payload),
+   - payload: lines concatenated, without separator.
+   Opening only maps the file, and any line is then accessed in O(1). */
+class BinaryTrack
+{
+public:
+	static constexpr char magic[4] = {'I', 'P', 'T', 'K'};
+	static constexpr std::uint32_t version = 1;
+
+	static bool hasMagic(std::string_view content);
+
+	BinaryTrack() = default;
+	explicit BinaryTrack(const std::filesystem::path&); // !isOpen() if missing or invalid
+
+	bool isOpen() const { return valid; }
+
+	std::string_view getTitle() const { return title; }
+	std::chrono::seconds getDuration() const { return duration; }
+	std::string_view getMetadata() const { return metadata; }
+
+	std::size_t getLineCount() const { return lineCount; }
+	std::string_view getLine(std::size_t) const; // empty if corrupted
+
+private:
+	MappedFile file;
+	bool valid = false;
+	std::string_view title;
+	std::string_view metadata;
+	std::chrono::seconds duration{};
+	std::size_t lineCount = 0;
+	const char* offsets = nullptr; // unaligned std::uint64_t[lineCount + 1]
+	std::string_view payload;
+};
+
+void writeBinaryTrack(std::ostream&,
+                      std::string_view title,
+                      std::chrono::seconds duration,
+                      std::string_view metadata,
+                      const std::vector<std::string>& lines);
+
+enum class TrackFormat
+{
+	Text,
+	Binary
+};
+// Convert a track file (of any format) to `format`. Return false on invalid input.
+bool convertTrack(const std::filesystem::path& from,
+                  const std::filesystem::path& to,
+                  TrackFormat format);
+
+} // namespace iplayer
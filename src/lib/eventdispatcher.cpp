@@ -0,0 +1,77 @@
+#include "eventdispatcher.h"
+
+#include <utility>
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+EventDispatcher::EventDispatcher() : head(new Node), tail(head.load())
+{
+	thread = std::thread([this]() { run(); });
+}
+
+//------------------------------------------------------------------------------
+EventDispatcher::~EventDispatcher()
+{
+	stop();
+	while (tail) {
+		delete std::exchange(tail, tail->next.load());
+	}
+}
+
+//------------------------------------------------------------------------------
+void EventDispatcher::post(std::function<void()> task)
+{
+	Node* node = new Node;
+	node->task = std::move(task);
+	Node* previous = head.exchange(node, std::memory_order_acq_rel);
+	previous->next.store(node, std::memory_order_release);
+	pendingCount.fetch_add(1, std::memory_order_release);
+	pendingCount.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void EventDispatcher::stop()
+{
+	if (!thread.joinable()) {
+		return;
+	}
+	stopping = true;
+	pendingCount.fetch_add(1, std::memory_order_release); // wake up
+	pendingCount.notify_one();
+	thread.join();
+}
+
+//------------------------------------------------------------------------------
+EventDispatcher::Node* EventDispatcher::pop()
+{
+	Node* next = tail->next.load(std::memory_order_acquire);
+	if (!next) {
+		return nullptr;
+	}
+	delete std::exchange(tail, next); // `next` becomes the stub once its task is taken
+	return next;
+}
+
+//------------------------------------------------------------------------------
+void EventDispatcher::run()
+{
+	while (true) {
+		pendingCount.wait(0, std::memory_order_acquire);
+		if (stopping) {
+			return;
+		}
+		Node* node = pop();
+		if (!node) {
+			std::this_thread::yield(); // a producer is between its two steps
+			continue;
+		}
+		auto task = std::move(node->task);
+		node->task = nullptr;
+		pendingCount.fetch_sub(1, std::memory_order_relaxed);
+		task();
+	}
+}
+
+} // namespace iplayer
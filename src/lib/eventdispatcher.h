@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace iplayer
+{
+
+/* Run posted tasks, in posting order (per producer), on its own thread.
+   post() is lock-free (multi-producer single-consumer linked queue),
+   so time-sensitive threads can hand work over without waiting for it. */
+class EventDispatcher
+{
+public:
+	EventDispatcher();
+	~EventDispatcher(); // pending tasks are discarded
+
+	EventDispatcher(const EventDispatcher&) = delete;
+	EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+	void post(std::function<void()>);
+	// Stop the thread (not to be called from a task); later tasks are not run.
+	void stop();
+
+private:
+	struct Node
+	{
+		std::atomic<Node*> next = nullptr;
+		std::function<void()> task;
+	};
+
+	Node* pop(); // consumer only
+	void run();
+
+private:
+	std::atomic<Node*> head; // last pushed node
+	Node* tail; // consumed stub, its next is the oldest task
+	std::atomic<std::size_t> pendingCount = 0;
+	std::atomic<bool> stopping = false;
+	std::thread thread;
+};
+
+} // namespace iplayer
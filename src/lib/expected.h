@@ -0,0 +1,41 @@
+#pragma once
+
+#include <utility>
+#include <variant>
+
+namespace iplayer
+{
+
+template <typename E>
+struct Unexpected
+{
+	E error;
+};
+
+/* Minimal stand-in for C++23 std::expected: either a value or an error.
+   Same member names, so it can be replaced once the project moves to C++23. */
+template <typename T, typename E>
+class Expected
+{
+public:
+	Expected(T value) : data(std::in_place_index<0>, std::move(value)) {}
+	Expected(Unexpected<E> unexpected) : data(std::in_place_index<1>, std::move(unexpected.error)) {}
+
+	bool has_value() const { return data.index() == 0; }
+	explicit operator bool() const { return has_value(); }
+
+	// Throw std::bad_variant_access when holding an error.
+	T& value() { return std::get<0>(data); }
+	const T& value() const { return std::get<0>(data); }
+	T& operator*() { return *std::get_if<0>(&data); }
+	const T& operator*() const { return *std::get_if<0>(&data); }
+	T* operator->() { return std::get_if<0>(&data); }
+	const T* operator->() const { return std::get_if<0>(&data); }
+
+	const E& error() const { return *std::get_if<1>(&data); }
+
+private:
+	std::variant<T, E> data;
+};
+
+} // namespace iplayer
@@ -0,0 +1,327 @@
+#include "headercache.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#ifndef _WIN32
+# include <stdlib.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+// File layout: FileHeader, Record[count] sorted by path, then the string arena.
+constexpr char magic[4] = {'I', 'P', 'H', 'C'};
+constexpr std::uint32_t version = 1;
+
+struct FileHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint64_t count;
+};
+
+struct Record
+{
+	std::uint64_t pathOffset; // in arena
+	std::uint64_t titleOffset; // in arena
+	std::uint32_t pathSize;
+	std::uint32_t titleSize;
+	std::uint64_t fileSize;
+	std::int64_t modificationTime;
+	std::int64_t duration;
+};
+
+//------------------------------------------------------------------------------
+std::optional<std::pair<std::uint64_t, std::int64_t>> fileStamp(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	const auto size = std::filesystem::file_size(path, ec);
+	if (ec) {
+		return std::nullopt;
+	}
+	const auto time = std::filesystem::last_write_time(path, ec);
+	if (ec) {
+		return std::nullopt;
+	}
+	return std::pair<std::uint64_t, std::int64_t>(size, time.time_since_epoch().count());
+}
+
+//------------------------------------------------------------------------------
+std::string cacheKey(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	const auto absolute = std::filesystem::absolute(path, ec);
+	return (ec ? path : absolute).lexically_normal().generic_string();
+}
+
+//------------------------------------------------------------------------------
+// Write `data` to a new file next to `file` and return its path. On POSIX, the file is created
+// exclusively, with a unique name: an existing file or symlink is never written through.
+std::optional<std::filesystem::path> writeTemporaryFile(const std::filesystem::path& file,
+                                                        std::string_view data)
+{
+#ifndef _WIN32
+	std::string name = file.string() + ".XXXXXX";
+	const int fd = ::mkstemp(name.data());
+	if (fd < 0) {
+		return std::nullopt;
+	}
+	bool ok = true;
+	while (ok && !data.empty()) {
+		const auto written = ::write(fd, data.data(), data.size());
+		if (written >= 0) {
+			data.remove_prefix(static_cast<std::size_t>(written));
+		} else {
+			ok = errno == EINTR;
+		}
+	}
+	ok = ::close(fd) == 0 && ok;
+	if (!ok) {
+		::unlink(name.c_str());
+		return std::nullopt;
+	}
+	return std::filesystem::path(name);
+#else
+	auto tmpFile = file;
+	tmpFile += ".tmp";
+	std::ofstream os(tmpFile, std::ios::binary);
+	os.write(data.data(), static_cast<std::streamsize>(data.size()));
+	if (!os) {
+		return std::nullopt;
+	}
+	return tmpFile;
+#endif
+}
+
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+HeaderCache& HeaderCache::global()
+{
+	static HeaderCache cache;
+	return cache;
+}
+
+//------------------------------------------------------------------------------
+std::filesystem::path HeaderCache::defaultFile()
+{
+	auto absoluteVariable = [](const char* name) -> std::filesystem::path {
+		const char* value = std::getenv(name);
+		return value && std::filesystem::path(value).is_absolute() ? value : "";
+	};
+	auto dir = absoluteVariable("XDG_CACHE_HOME");
+	if (dir.empty()) {
+		dir = absoluteVariable("HOME");
+		if (dir.empty()) {
+			return {};
+		}
+		dir /= ".cache";
+	}
+	return dir / "iplayer" / "headers.cache";
+}
+
+//------------------------------------------------------------------------------
+void HeaderCache::open(const std::filesystem::path& file)
+{
+	std::lock_guard l(mutex);
+	cacheFile = std::filesystem::absolute(file);
+	mapped = MappedFile(cacheFile);
+	updates.clear();
+
+	FileHeader header;
+	const auto data = mapped.data();
+	if (data.size() < sizeof(header)) {
+		mapped = MappedFile();
+	} else {
+		std::memcpy(&header, data.data(), sizeof(header));
+		if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version
+		    || (data.size() - sizeof(header)) / sizeof(Record) < header.count) {
+			mapped = MappedFile();
+		}
+	}
+	opened = true;
+}
+
+//------------------------------------------------------------------------------
+std::optional<HeaderCache::Entry> HeaderCache::findMapped(const std::string& path) const
+{
+	const auto data = mapped.data();
+	if (data.empty()) {
+		return std::nullopt;
+	}
+	FileHeader header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	const char* records = data.data() + sizeof(header);
+	const auto arena = data.substr(sizeof(header) + header.count * sizeof(Record));
+
+	auto recordAt = [&](std::size_t i) {
+		Record record;
+		std::memcpy(&record, records + i * sizeof(Record), sizeof(Record));
+		return record;
+	};
+	auto stringAt = [&](std::uint64_t offset, std::uint32_t size) -> std::optional<std::string_view> {
+		if (arena.size() < offset || arena.size() - offset < size) {
+			return std::nullopt; // corrupted
+		}
+		return arena.substr(offset, size);
+	};
+	std::size_t first = 0;
+	std::size_t last = header.count;
+	while (first < last) {
+		const auto middle = first + (last - first) / 2;
+		const auto record = recordAt(middle);
+		const auto recordPath = stringAt(record.pathOffset, record.pathSize);
+		if (!recordPath) {
+			return std::nullopt;
+		}
+		if (*recordPath < path) {
+			first = middle + 1;
+		} else if (path < *recordPath) {
+			last = middle;
+		} else {
+			const auto title = stringAt(record.titleOffset, record.titleSize);
+			if (!title) {
+				return std::nullopt;
+			}
+			return Entry{record.fileSize, record.modificationTime, std::string(*title), record.duration};
+		}
+	}
+	return std::nullopt;
+}
+
+//------------------------------------------------------------------------------
+bool HeaderCache::lookup(const std::filesystem::path& path, TrackHeader& out)
+{
+	if (!opened) {
+		return false;
+	}
+	const auto key = cacheKey(path);
+	std::optional<Entry> entry;
+	{
+		std::lock_guard l(mutex);
+		if (auto it = updates.find(key); it != updates.end()) {
+			entry = it->second;
+		} else {
+			entry = findMapped(key);
+		}
+	}
+	if (!entry) {
+		return false;
+	}
+	const auto stamp = fileStamp(path);
+	if (!stamp || stamp->first != entry->fileSize || stamp->second != entry->modificationTime) {
+		return false; // stale
+	}
+	out.filename = path;
+	out.title = std::move(entry->title);
+	out.duration = std::chrono::seconds(entry->duration);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void HeaderCache::store(const TrackHeader& track)
+{
+	if (!opened) {
+		return;
+	}
+	const auto path = track.filename.path();
+	const auto stamp = fileStamp(path);
+	if (!stamp) {
+		return;
+	}
+	Entry entry{stamp->first, stamp->second, track.title, track.duration.count()};
+	const auto key = cacheKey(path);
+	std::lock_guard l(mutex);
+	updates.insert_or_assign(key, std::move(entry));
+}
+
+//------------------------------------------------------------------------------
+bool HeaderCache::save()
+{
+	if (!opened) {
+		return false;
+	}
+	std::lock_guard l(mutex);
+	std::map<std::string, Entry> entries; // sorted by path, as required by lookup
+
+	if (const auto data = mapped.data(); !data.empty()) {
+		FileHeader header;
+		std::memcpy(&header, data.data(), sizeof(header));
+		const auto arena = data.substr(sizeof(header) + header.count * sizeof(Record));
+		for (std::size_t i = 0; i != header.count; ++i) {
+			Record record;
+			std::memcpy(&record, data.data() + sizeof(header) + i * sizeof(Record), sizeof(Record));
+			if (arena.size() < record.pathOffset || arena.size() < record.titleOffset
+			    || arena.size() - record.pathOffset < record.pathSize
+			    || arena.size() - record.titleOffset < record.titleSize) {
+				continue;
+			}
+			entries.emplace(
+				std::string(arena.substr(record.pathOffset, record.pathSize)),
+				Entry{record.fileSize,
+			          record.modificationTime,
+			          std::string(arena.substr(record.titleOffset, record.titleSize)),
+			          record.duration});
+		}
+	}
+	for (auto& [path, entry] : updates) {
+		entries.insert_or_assign(path, entry);
+	}
+
+	std::string content;
+	auto append = [&content](const auto& value) {
+		content.append(reinterpret_cast<const char*>(&value), sizeof(value));
+	};
+	FileHeader header{};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.count = entries.size();
+	append(header);
+
+	std::uint64_t offset = 0;
+	for (const auto& [path, entry] : entries) {
+		Record record{};
+		record.pathOffset = offset;
+		record.pathSize = static_cast<std::uint32_t>(path.size());
+		record.titleOffset = offset + path.size();
+		record.titleSize = static_cast<std::uint32_t>(entry.title.size());
+		record.fileSize = entry.fileSize;
+		record.modificationTime = entry.modificationTime;
+		record.duration = entry.duration;
+		offset += path.size() + entry.title.size();
+		append(record);
+	}
+	for (const auto& [path, entry] : entries) {
+		content += path;
+		content += entry.title;
+	}
+
+	std::error_code ec;
+	const auto dir = cacheFile.parent_path();
+	if (std::filesystem::create_directories(dir, ec)) {
+		// Only the cache directory: its parents may be shared.
+		std::filesystem::permissions(dir, std::filesystem::perms::owner_all, ec);
+	}
+	const auto tmpFile = writeTemporaryFile(cacheFile, content);
+	if (!tmpFile) {
+		return false;
+	}
+	mapped = MappedFile(); // unmap before replacing it
+	std::filesystem::rename(*tmpFile, cacheFile, ec);
+	mapped = MappedFile(cacheFile);
+	if (ec) {
+		std::filesystem::remove(*tmpFile, ec);
+		return false;
+	}
+	updates.clear();
+	return true;
+}
+
+} // namespace iplayer
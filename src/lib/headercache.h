@@ -0,0 +1,61 @@
+#pragma once
+
+#include "mappedfile.h"
+#include "trackheader.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace iplayer
+{
+
+/* On-disk cache of parsed track headers, keyed by (absolute path, size, modification time).
+   The cache file is memory-mapped and its entries are only validated (by a stat) on lookup,
+   so a warm start does not open any track file. */
+class HeaderCache
+{
+public:
+	static HeaderCache& global(); // used by openTrackHeader and readTrackHeader once opened
+	// Per-user cache file: $XDG_CACHE_HOME/iplayer/headers.cache, else under ~/.cache.
+	// Empty if neither variable gives an absolute directory.
+	static std::filesystem::path defaultFile();
+
+	HeaderCache() = default;
+	HeaderCache(const HeaderCache&) = delete;
+	HeaderCache& operator=(const HeaderCache&) = delete;
+
+	// Map `cacheFile` (a missing or invalid file just gives an empty cache), and enable the cache.
+	void open(const std::filesystem::path& cacheFile);
+	// Write all valid known entries back to the cache file, through a new temporary file.
+	bool save();
+	bool isOpen() const { return opened; }
+
+	// Fill `out` if an up-to-date entry exists for `path`.
+	bool lookup(const std::filesystem::path&, TrackHeader& out);
+	void store(const TrackHeader&);
+
+private:
+	struct Entry
+	{
+		std::uint64_t fileSize;
+		std::int64_t modificationTime;
+		std::string title;
+		std::int64_t duration;
+	};
+
+	std::optional<Entry> findMapped(const std::string& path) const;
+
+private:
+	std::atomic<bool> opened = false;
+	std::filesystem::path cacheFile;
+	MappedFile mapped;
+	std::mutex mutex;
+	std::unordered_map<std::string, Entry> updates; // by absolute path, newer than mapped ones
+};
+
+} // namespace iplayer
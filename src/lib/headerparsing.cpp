@@ -0,0 +1,50 @@
+#include "headerparsing.h"
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+bool isHeaderSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+//------------------------------------------------------------------------------
+void skipHeaderSpaces(std::string_view::const_iterator& it, std::string_view::const_iterator end)
+{
+	while (it != end && isHeaderSpace(*it)) {
+		++it;
+	}
+}
+
+//------------------------------------------------------------------------------
+bool readHeaderWord(std::string_view::const_iterator& it,
+                    std::string_view::const_iterator end,
+                    std::string& out)
+{
+	out.clear();
+	if (it == end || *it != '"') {
+		const auto first = it;
+		while (it != end && !isHeaderSpace(*it)) {
+			++it;
+		}
+		out.assign(first, it);
+		return true;
+	}
+	for (++it;; ++it) {
+		if (it == end) {
+			return false;
+		}
+		if (*it == '\\') {
+			if (++it == end) {
+				return false;
+			}
+		} else if (*it == '"') {
+			++it;
+			return true;
+		}
+		out += *it;
+	}
+}
+
+} // namespace iplayer
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace iplayer
+{
+
+// Lexing shared by the track header and metadata parsers, with the grammar of operator>>.
+
+// Whitespace of the "C" locale.
+bool isHeaderSpace(char);
+void skipHeaderSpaces(std::string_view::const_iterator& it, std::string_view::const_iterator end);
+// Read a word, or a quoted string with '\' escapes (as std::quoted), into `out`.
+// False on an unterminated quote.
+bool readHeaderWord(std::string_view::const_iterator& it,
+                    std::string_view::const_iterator end,
+                    std::string& out);
+
+} // namespace iplayer
@@ -16,7 +16,15 @@ public:
 	virtual void play() = 0;
 	virtual void setElapsedTime(const std::chrono::seconds&) = 0;
 	virtual std::chrono::seconds getElapsedTime() = 0;
+	// Sub-second versions, defaulted to the ones above.
+	virtual std::chrono::milliseconds getPosition() { return getElapsedTime(); }
+	virtual void seek(std::chrono::milliseconds position)
+	{
+		setElapsedTime(std::chrono::floor<std::chrono::seconds>(position));
+	}
 	virtual void setOnMusicFinished(std::function<void()>) = 0;
+	// Hint that `path` is likely the next one opened: it may be loaded in the background.
+	virtual void prefetch(const std::filesystem::path&) {}
 };
 
 } // namespace iplayer
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "internedpath.h"
+
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+
+/* Append-only string pool; id 0 is the empty string. */
+class StringPool
+{
+public:
+	StringPool() { intern(""); }
+
+	std::uint32_t intern(std::string_view s)
+	{
+		{
+			std::shared_lock l(mutex);
+			if (auto it = ids.find(s); it != ids.end()) {
+				return it->second;
+			}
+		}
+		std::unique_lock l(mutex);
+		if (auto it = ids.find(s); it != ids.end()) {
+			return it->second;
+		}
+		const auto id = static_cast<std::uint32_t>(strings.size());
+		strings.emplace_back(s);
+		ids.emplace(strings.back(), id); // deque elements never move
+		return id;
+	}
+
+	const std::string& get(std::uint32_t id)
+	{
+		std::shared_lock l(mutex);
+		return strings[id];
+	}
+
+private:
+	std::shared_mutex mutex;
+	std::deque<std::string> strings;
+	std::unordered_map<std::string_view, std::uint32_t> ids;
+};
+
+//------------------------------------------------------------------------------
+StringPool& directories()
+{
+	static StringPool pool;
+	return pool;
+}
+
+//------------------------------------------------------------------------------
+StringPool& names()
+{
+	static StringPool pool;
+	return pool;
+}
+
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+InternedPath::InternedPath(const std::filesystem::path& p) :
+	directoryId(directories().intern(p.parent_path().generic_string())),
+	nameId(names().intern(p.filename().generic_string()))
+{}
+
+//------------------------------------------------------------------------------
+std::filesystem::path InternedPath::path() const
+{
+	return std::filesystem::path(directories().get(directoryId)) / names().get(nameId);
+}
+
+//------------------------------------------------------------------------------
+std::filesystem::path InternedPath::filename() const
+{
+	return names().get(nameId);
+}
+
+//------------------------------------------------------------------------------
+std::ostream& operator<<(std::ostream& os, const InternedPath& p)
+{
+	return os << p.path();
+}
+
+} // namespace iplayer
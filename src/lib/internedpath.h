@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+namespace iplayer
+{
+
+/* Compact path: its directory and file name are each stored once in a process-wide pool,
+   so a path is two integer ids and equality/hashing are integer operations. */
+class InternedPath
+{
+public:
+	InternedPath() = default; // empty path
+	InternedPath(const std::filesystem::path&);
+	InternedPath(const std::string& s) : InternedPath(std::filesystem::path(s)) {}
+	InternedPath(const char* s) : InternedPath(std::filesystem::path(s)) {}
+
+	std::filesystem::path path() const;
+	operator std::filesystem::path() const { return path(); }
+	std::filesystem::path filename() const;
+	std::string string() const { return path().string(); }
+	bool empty() const { return directoryId == 0 && nameId == 0; }
+
+	std::size_t hash() const
+	{
+		return std::hash<std::uint64_t>{}((std::uint64_t(directoryId) << 32) | nameId);
+	}
+
+	bool operator==(const InternedPath&) const = default;
+	// Avoid ambiguity with std::filesystem::path comparison.
+	bool operator==(const std::filesystem::path& rhs) const { return path() == rhs; }
+
+private:
+	std::uint32_t directoryId = 0;
+	std::uint32_t nameId = 0;
+};
+
+std::ostream& operator<<(std::ostream&, const InternedPath&);
+
+} // namespace iplayer
+
+template <>
+struct std::hash<iplayer::InternedPath>
+{
+	std::size_t operator()(const iplayer::InternedPath& p) const noexcept { return p.hash(); }
+};
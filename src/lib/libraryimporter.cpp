@@ -0,0 +1,108 @@
+#include "libraryimporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+std::vector<std::filesystem::path> listFiles(const std::filesystem::path& directory)
+{
+	std::vector<std::filesystem::path> res;
+	const auto options = std::filesystem::directory_options::skip_permission_denied;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, options)) {
+		if (entry.is_regular_file()) {
+			res.push_back(entry.path());
+		}
+	}
+	std::sort(res.begin(), res.end());
+	return res;
+}
+
+struct Batch
+{
+	std::vector<iplayer::TrackHeader> tracks;
+	std::vector<iplayer::InvalidFile> invalidFiles;
+	std::exception_ptr exception; // thrown while reading, rethrown by the importing thread
+	bool ready = false;
+};
+
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+ImportSummary importDirectory(Player& player,
+                              const std::filesystem::path& directory,
+                              const ImportOptions& options)
+{
+	const auto files = listFiles(directory);
+	const auto batchSize = std::max<std::size_t>(1, options.batchSize);
+	const auto batchCount = (files.size() + batchSize - 1) / batchSize;
+	const auto threadCount = std::min<std::size_t>(
+		batchCount,
+		options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency()));
+
+	std::vector<Batch> batches(batchCount);
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::atomic<std::size_t> nextBatch = 0;
+
+	auto worker = [&](std::stop_token stop) {
+		for (auto b = nextBatch++; b < batchCount && !stop.stop_requested(); b = nextBatch++) {
+			Batch batch;
+			try {
+				const auto last = std::min(files.size(), (b + 1) * batchSize);
+				batch.tracks.reserve(last - b * batchSize);
+				TrackHeader track;
+				TrackHeaderError error;
+				for (std::size_t i = b * batchSize; i != last; ++i) {
+					if (readTrackHeader(files[i], track, error)) {
+						batch.tracks.push_back(std::move(track));
+					} else {
+						batch.invalidFiles.push_back({files[i], error});
+					}
+				}
+			}
+			catch (...) {
+				batch.exception = std::current_exception();
+			}
+			batch.ready = true;
+			std::lock_guard l(mutex);
+			batches[b] = std::move(batch);
+			cv.notify_all();
+		}
+	};
+	// Joined, once asked to stop, whichever way this function exits.
+	std::vector<std::jthread> threads;
+	threads.reserve(threadCount);
+	for (std::size_t i = 0; i != threadCount; ++i) {
+		threads.emplace_back(worker);
+	}
+
+	ImportSummary summary;
+	for (auto& batch : batches) {
+		Batch ready;
+		{
+			std::unique_lock l(mutex);
+			cv.wait(l, [&]() { return batch.ready; });
+			ready = std::move(batch);
+		}
+		if (ready.exception) {
+			std::rethrow_exception(ready.exception);
+		}
+		summary.importedCount += ready.tracks.size();
+		summary.invalidFiles.insert(
+			summary.invalidFiles.end(), ready.invalidFiles.begin(), ready.invalidFiles.end());
+		player.append(ready.tracks);
+	}
+	return summary;
+}
+
+} // namespace iplayer
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "player.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace iplayer
+{
+
+struct ImportOptions
+{
+	std::size_t threadCount = 0; // 0 for hardware concurrency
+	std::size_t batchSize = 1024; // tracks appended to the player at once
+};
+
+struct InvalidFile
+{
+	std::filesystem::path path;
+	TrackHeaderError error;
+
+	bool operator==(const InvalidFile&) const = default;
+};
+
+struct ImportSummary
+{
+	std::size_t importedCount = 0;
+	std::vector<InvalidFile> invalidFiles; // missing or bad header
+};
+
+// Add all track files found (recursively) in `directory` to `player`, sorted by path.
+// Headers are parsed on a thread pool, and appended in order by batches.
+// An exception (of a read or of the append) is rethrown once the pool has stopped.
+ImportSummary importDirectory(Player&, const std::filesystem::path& directory, const ImportOptions& = {});
+
+} // namespace iplayer
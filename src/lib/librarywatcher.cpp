@@ -0,0 +1,242 @@
+#include "librarywatcher.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#ifdef __linux__
+# include <poll.h>
+# include <sys/eventfd.h>
+# include <sys/inotify.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+constexpr std::uint32_t directoryMask =
+	IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF
+	| IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+LibraryWatcher::LibraryWatcher(Callback callback, std::chrono::milliseconds latency) :
+	callback(std::move(callback)),
+	latency(latency)
+{
+#ifdef __linux__
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (inotifyFd < 0 || stopFd < 0) {
+		return;
+	}
+	thread = std::thread([this]() { run(); });
+#endif
+}
+
+//------------------------------------------------------------------------------
+LibraryWatcher::~LibraryWatcher()
+{
+#ifdef __linux__
+	if (thread.joinable()) {
+		const std::uint64_t one = 1;
+		[[maybe_unused]] const auto res = ::write(stopFd, &one, sizeof(one));
+		thread.join();
+	}
+	if (inotifyFd >= 0) {
+		::close(inotifyFd);
+	}
+	if (stopFd >= 0) {
+		::close(stopFd);
+	}
+#endif
+}
+
+//------------------------------------------------------------------------------
+bool LibraryWatcher::isSupported()
+{
+#ifdef __linux__
+	return true;
+#else
+	return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+bool LibraryWatcher::watch(const std::filesystem::path& directory, bool recursive)
+{
+	if (!thread.joinable()) {
+		return false;
+	}
+	std::lock_guard l(mutex);
+	return addWatch(directory, recursive);
+}
+
+//------------------------------------------------------------------------------
+bool LibraryWatcher::addWatch(const std::filesystem::path& directory, bool recursive)
+{
+#ifdef __linux__
+	std::error_code ec;
+	const auto absolute = std::filesystem::absolute(directory, ec).lexically_normal();
+	const int wd = inotify_add_watch(inotifyFd, absolute.c_str(), directoryMask);
+	if (wd < 0) {
+		return false;
+	}
+	directories[wd] = {absolute, recursive};
+	if (recursive) {
+		// Never throwing: the directory may change while it is listed.
+		const auto options = std::filesystem::directory_options::skip_permission_denied;
+		std::filesystem::directory_iterator it(absolute, options, ec);
+		for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+			std::error_code entryEc;
+			if (it->is_directory(entryEc)) {
+				addWatch(it->path(), true);
+			}
+		}
+	}
+	return true;
+#else
+	(void) directory;
+	(void) recursive;
+	return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+void LibraryWatcher::run()
+{
+#ifdef __linux__
+	LibraryChanges pending;
+	auto flush = [&]() {
+		for (auto* paths : {&pending.files, &pending.removedDirectories}) {
+			std::sort(paths->begin(), paths->end());
+			paths->erase(std::unique(paths->begin(), paths->end()), paths->end());
+		}
+		callback(std::exchange(pending, {}));
+	};
+	pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+	std::chrono::steady_clock::time_point deadline;
+
+	while (true) {
+		// Wait forever while idle, until `latency` after the first pending event otherwise.
+		int timeout = -1;
+		if (!pending.empty()) {
+			const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+				deadline - std::chrono::steady_clock::now());
+			timeout = static_cast<int>(std::max<std::int64_t>(0, remaining.count()));
+		}
+		const int res = ::poll(fds, 2, timeout);
+		if (res < 0) {
+			continue; // EINTR
+		}
+		if (fds[1].revents & POLLIN) {
+			return;
+		}
+		if (fds[0].revents & POLLIN) {
+			const bool wasEmpty = pending.empty();
+			readEvents(pending);
+			if (wasEmpty) {
+				deadline = std::chrono::steady_clock::now() + latency;
+			}
+		}
+		if (!pending.empty() && deadline <= std::chrono::steady_clock::now()) {
+			flush();
+		}
+	}
+#endif
+}
+
+//------------------------------------------------------------------------------
+void LibraryWatcher::readEvents(LibraryChanges& pending)
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+	std::lock_guard l(mutex);
+
+	while (true) {
+		const auto size = ::read(inotifyFd, buffer, sizeof(buffer));
+		if (size <= 0) {
+			return;
+		}
+		for (const char* p = buffer; p < buffer + size;) {
+			const auto* event = reinterpret_cast<const inotify_event*>(p);
+			p += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				pending.overflow = true;
+				continue;
+			}
+			if (event->mask & IN_IGNORED) {
+				directories.erase(event->wd); // directory removed
+				continue;
+			}
+			const auto it = directories.find(event->wd);
+			if (it == directories.end()) {
+				continue;
+			}
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) { // e.g. a watched root
+				removeWatches(std::filesystem::path(it->second.path), pending);
+				continue;
+			}
+			if (event->len == 0) {
+				continue;
+			}
+			const auto path = it->second.path / event->name;
+			if (!(event->mask & IN_ISDIR)) {
+				if (!(event->mask & IN_CREATE)) { // wait for IN_CLOSE_WRITE instead
+					pending.files.push_back(path);
+				}
+				continue;
+			}
+			if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+				removeWatches(path, pending);
+			} else if (it->second.recursive && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+				// Files may be added before the watch: report existing ones.
+				addWatch(path, true);
+				const auto options = std::filesystem::directory_options::skip_permission_denied;
+				std::error_code ec;
+				std::filesystem::recursive_directory_iterator entry(path, options, ec);
+				for (; !ec && entry != std::filesystem::recursive_directory_iterator();
+				     entry.increment(ec)) {
+					std::error_code entryEc;
+					if (entry->is_regular_file(entryEc)) {
+						pending.files.push_back(entry->path());
+					}
+				}
+			}
+		}
+	}
+#else
+	(void) pending;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Report `directory` and its watched sub-directories as removed, and stop watching them
+// (a moved directory would be reported with its old path otherwise).
+void LibraryWatcher::removeWatches(const std::filesystem::path& directory, LibraryChanges& pending)
+{
+#ifdef __linux__
+	pending.removedDirectories.push_back(directory);
+	for (auto it = directories.begin(); it != directories.end();) {
+		const auto& path = it->second.path;
+		if (std::mismatch(directory.begin(), directory.end(), path.begin(), path.end()).first
+		    == directory.end()) {
+			pending.removedDirectories.push_back(path);
+			inotify_rm_watch(inotifyFd, it->first);
+			it = directories.erase(it);
+		} else {
+			++it;
+		}
+	}
+#else
+	(void) directory;
+	(void) pending;
+#endif
+}
+
+} // namespace iplayer
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace iplayer
+{
+
+struct LibraryChanges
+{
+	std::vector<std::filesystem::path> files; // created, modified, moved or deleted
+	// Moved away or deleted, with their watched sub-directories: files under them are gone.
+	std::vector<std::filesystem::path> removedDirectories;
+	bool overflow = false; // events were lost: everything watched should be rescanned
+
+	bool empty() const { return files.empty() && removedDirectories.empty() && !overflow; }
+};
+
+/* Watch directories for created, modified, moved or deleted files (with inotify on Linux,
+   no-op elsewhere), and report them by batches to a callback, from its own thread.
+   Events are coalesced during `latency`, so a file written in several steps is reported once. */
+class LibraryWatcher
+{
+public:
+	using Callback = std::function<void(LibraryChanges)>;
+
+	explicit LibraryWatcher(Callback,
+	                        std::chrono::milliseconds latency = std::chrono::milliseconds(100));
+	~LibraryWatcher();
+
+	LibraryWatcher(const LibraryWatcher&) = delete;
+	LibraryWatcher& operator=(const LibraryWatcher&) = delete;
+
+	static bool isSupported();
+
+	// Sub-directories created later are watched too when `recursive`.
+	// Return false if the directory cannot be watched.
+	bool watch(const std::filesystem::path& directory, bool recursive = true);
+
+private:
+	bool addWatch(const std::filesystem::path& directory, bool recursive);
+	void run();
+	void readEvents(LibraryChanges& pending);
+	void removeWatches(const std::filesystem::path& directory, LibraryChanges& pending);
+
+private:
+	struct WatchedDirectory
+	{
+		std::filesystem::path path;
+		bool recursive;
+	};
+
+	Callback callback;
+	std::chrono::milliseconds latency;
+	int inotifyFd = -1;
+	int stopFd = -1;
+	std::mutex mutex;
+	std::unordered_map<int, WatchedDirectory> directories; // by watch descriptor
+	std::thread thread;
+};
+
+} // namespace iplayer
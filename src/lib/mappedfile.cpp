@@ -0,0 +1,94 @@
+#include "mappedfile.h"
+
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+#ifndef _WIN32
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		opened = true;
+		size = static_cast<std::size_t>(st.st_size);
+		if (size != 0) {
+			void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) {
+				begin = static_cast<const char*>(p);
+				mapped = true;
+			} else {
+				opened = false;
+				size = 0;
+			}
+		}
+	}
+	::close(fd);
+#else
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return;
+	}
+	buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	begin = buffer.data();
+	size = buffer.size();
+	opened = true;
+#endif
+}
+
+//------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	reset();
+}
+
+//------------------------------------------------------------------------------
+MappedFile::MappedFile(MappedFile&& rhs) noexcept
+{
+	*this = std::move(rhs);
+}
+
+//------------------------------------------------------------------------------
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+	if (this != &rhs) {
+		reset();
+		begin = std::exchange(rhs.begin, nullptr);
+		size = std::exchange(rhs.size, 0);
+		opened = std::exchange(rhs.opened, false);
+		mapped = std::exchange(rhs.mapped, false);
+		buffer = std::move(rhs.buffer);
+	}
+	return *this;
+}
+
+//------------------------------------------------------------------------------
+void MappedFile::reset()
+{
+#ifndef _WIN32
+	if (mapped) {
+		::munmap(const_cast<char*>(begin), size);
+	}
+#endif
+	begin = nullptr;
+	size = 0;
+	opened = false;
+	mapped = false;
+	buffer.clear();
+}
+
+} // namespace iplayer
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace iplayer
+{
+
+/* Read-only view of a whole file, memory-mapped when the platform allows it. */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::filesystem::path&); // !isOpen() on failure
+	~MappedFile();
+
+	MappedFile(MappedFile&&) noexcept;
+	MappedFile& operator=(MappedFile&&) noexcept;
+
+	bool isOpen() const { return opened; }
+	std::string_view data() const { return {begin, size}; }
+
+private:
+	void reset();
+
+private:
+	const char* begin = nullptr;
+	std::size_t size = 0;
+	bool opened = false;
+	bool mapped = false;
+	std::vector<char> buffer; // fallback when not mapped
+};
+
+} // namespace iplayer
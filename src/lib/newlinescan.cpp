@@ -0,0 +1,71 @@
+#include "newlinescan.h"
+
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+# define IPLAYER_AVX2_SCAN 1
+# include <immintrin.h>
+#endif
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+void findNewlinesScalar(const char* data,
+                        std::size_t size,
+                        std::size_t offset,
+                        std::vector<std::size_t>& positions)
+{
+	const char* end = data + size;
+	for (const char* p = data; (p = static_cast<const char*>(std::memchr(p, '\n', end - p))); ++p) {
+		positions.push_back(offset + (p - data));
+	}
+}
+
+#ifdef IPLAYER_AVX2_SCAN
+//------------------------------------------------------------------------------
+// Compiled for AVX2 whatever the global flags, only called after a runtime check.
+__attribute__((target("avx2"))) void
+findNewlinesAvx2(const char* data, std::size_t size, std::vector<std::size_t>& positions)
+{
+	const __m256i newline = _mm256_set1_epi8('\n');
+	std::size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+		while (mask) {
+			positions.push_back(i + __builtin_ctz(mask));
+			mask &= mask - 1;
+		}
+	}
+	findNewlinesScalar(data + i, size - i, i, positions);
+}
+
+//------------------------------------------------------------------------------
+bool hasAvx2()
+{
+	static const bool res = __builtin_cpu_supports("avx2");
+	return res;
+}
+#endif
+
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+void findNewlines(std::string_view s, std::vector<std::size_t>& positions, bool allowSimd)
+{
+#ifdef IPLAYER_AVX2_SCAN
+	if (allowSimd && hasAvx2()) {
+		findNewlinesAvx2(s.data(), s.size(), positions);
+		return;
+	}
+#else
+	(void) allowSimd;
+#endif
+	findNewlinesScalar(s.data(), s.size(), 0, positions);
+}
+
+} // namespace iplayer
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace iplayer
+{
+
+// Append positions of all '\n' of `s` to `positions`.
+// Uses AVX2 when the CPU supports it (and `allowSimd`), a memchr loop otherwise.
+void findNewlines(std::string_view s, std::vector<std::size_t>& positions, bool allowSimd = true);
+
+} // namespace iplayer
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace iplayer
+{
+
+/* Sequence container with O(log n) positional access, insertion, removal and move.
+   Implemented as an implicit treap: nodes are ordered by position and kept balanced
+   (in expectation) by random priorities. Each node knows its subtree size and its parent.
+   Iterators (except end()) stay valid until their element is erased. */
+template <typename T>
+class OrderStatisticTree
+{
+	struct Node
+	{
+		template <typename... Ts>
+		explicit Node(std::uint32_t priority, Ts&&... args) :
+			value(std::forward<Ts>(args)...),
+			priority(priority)
+		{}
+
+		T value;
+		Node* left = nullptr;
+		Node* right = nullptr;
+		Node* parent = nullptr;
+		std::size_t size = 1;
+		std::uint32_t priority;
+	};
+
+public:
+	using value_type = T;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+
+	class const_iterator
+	{
+	public:
+		using iterator_concept = std::bidirectional_iterator_tag;
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		const_iterator() = default;
+
+		reference operator*() const { return node->value; }
+		pointer operator->() const { return &node->value; }
+
+		const_iterator& operator++()
+		{
+			node = successor(node);
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			auto res = *this;
+			++*this;
+			return res;
+		}
+		const_iterator& operator--()
+		{
+			node = node ? predecessor(node) : rightmost(tree->root);
+			return *this;
+		}
+		const_iterator operator--(int)
+		{
+			auto res = *this;
+			--*this;
+			return res;
+		}
+
+		bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+
+	private:
+		friend class OrderStatisticTree;
+		const_iterator(const OrderStatisticTree* tree, const Node* node) : tree(tree), node(node) {}
+
+		const OrderStatisticTree* tree = nullptr;
+		const Node* node = nullptr;
+	};
+	using iterator = const_iterator;
+
+	OrderStatisticTree() = default;
+	OrderStatisticTree(const OrderStatisticTree& rhs) { assign(rhs.begin(), rhs.end()); }
+	OrderStatisticTree(OrderStatisticTree&& rhs) noexcept :
+		root(std::exchange(rhs.root, nullptr)),
+		seed(rhs.seed)
+	{}
+	~OrderStatisticTree() { destroy(root); }
+
+	OrderStatisticTree& operator=(OrderStatisticTree rhs) noexcept
+	{
+		std::swap(root, rhs.root);
+		std::swap(seed, rhs.seed);
+		return *this;
+	}
+
+	std::size_t size() const { return sizeOf(root); }
+	bool empty() const { return root == nullptr; }
+
+	const_iterator begin() const { return {this, leftmost(root)}; }
+	const_iterator end() const { return {this, nullptr}; }
+
+	const T& operator[](std::size_t pos) const { return nodeAt(pos)->value; }
+	T& operator[](std::size_t pos) { return nodeAt(pos)->value; }
+	const T& at(std::size_t pos) const
+	{
+		if (size() <= pos) {
+			throw std::out_of_range("OrderStatisticTree::at");
+		}
+		return (*this)[pos];
+	}
+	const T& front() const { return leftmost(root)->value; }
+	const T& back() const { return rightmost(root)->value; }
+
+	// Position of the element pointed by `it` (which should not be end()).
+	std::size_t indexOf(const_iterator it) const { return rank(it.node); }
+	const_iterator iteratorAt(std::size_t pos) const { return {this, nodeAt(pos)}; }
+
+	template <typename... Ts>
+	const_iterator emplace(std::size_t pos, Ts&&... args)
+	{
+		Node* node = new Node(nextPriority(), std::forward<Ts>(args)...);
+		auto [l, r] = split(root, pos);
+		setRoot(merge(merge(l, node), r));
+		return {this, node};
+	}
+	template <typename... Ts>
+	const_iterator emplace_back(Ts&&... args)
+	{
+		return emplace(size(), std::forward<Ts>(args)...);
+	}
+	const_iterator insert(std::size_t pos, T value) { return emplace(pos, std::move(value)); }
+	const_iterator push_back(T value) { return emplace(size(), std::move(value)); }
+
+	void erase(std::size_t pos) { destroy(detach(pos)); }
+
+	// Move element at `from` so that it ends at position `to`, without copying it.
+	void move(std::size_t from, std::size_t to)
+	{
+		Node* node = detach(from);
+		auto [l, r] = split(root, to);
+		setRoot(merge(merge(l, node), r));
+	}
+
+	void clear()
+	{
+		destroy(root);
+		root = nullptr;
+	}
+
+	// Replace content with [first, last) in O(n).
+	template <typename It>
+	void assign(It first, It last)
+	{
+		clear();
+		setRoot(build(first, last));
+	}
+
+	// Insert [first, last) before `pos` in O(k + log n).
+	// Return iterator to first inserted element (end() if none).
+	template <typename It>
+	const_iterator insert(std::size_t pos, It first, It last)
+	{
+		Node* range = build(first, last);
+		Node* firstInserted = leftmost(range);
+		auto [l, r] = split(root, pos);
+		setRoot(merge(merge(l, range), r));
+		return {this, firstInserted};
+	}
+
+	// Move all elements out (in order), leaving the tree empty.
+	std::vector<T> extract()
+	{
+		std::vector<T> res;
+		res.reserve(size());
+		for (Node* node = leftmost(root); node; node = successor(node)) {
+			res.push_back(std::move(node->value));
+		}
+		clear();
+		return res;
+	}
+
+private:
+	static std::size_t sizeOf(const Node* node) { return node ? node->size : 0; }
+
+	// Cartesian tree of [first, last) in O(n).
+	template <typename It>
+	Node* build(It first, It last)
+	{
+		Node* res = nullptr;
+		std::vector<Node*> stack; // right spine of the tree being built
+		for (; first != last; ++first) {
+			Node* node = new Node(nextPriority(), *first);
+			Node* last_popped = nullptr;
+			while (!stack.empty() && stack.back()->priority < node->priority) {
+				last_popped = stack.back();
+				stack.pop_back();
+			}
+			node->left = last_popped;
+			if (!stack.empty()) {
+				stack.back()->right = node;
+			} else {
+				res = node;
+			}
+			stack.push_back(node);
+		}
+		fixup(res);
+		if (res) {
+			res->parent = nullptr;
+		}
+		return res;
+	}
+
+	static Node* update(Node* node)
+	{
+		node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+		if (node->left) {
+			node->left->parent = node;
+		}
+		if (node->right) {
+			node->right->parent = node;
+		}
+		return node;
+	}
+
+	static void fixup(Node* node)
+	{
+		if (!node) {
+			return;
+		}
+		fixup(node->left);
+		fixup(node->right);
+		update(node);
+	}
+
+	// Split into [0, count) and [count, size).
+	static std::pair<Node*, Node*> split(Node* node, std::size_t count)
+	{
+		if (!node) {
+			return {nullptr, nullptr};
+		}
+		if (count <= sizeOf(node->left)) {
+			auto [l, r] = split(node->left, count);
+			node->left = r;
+			return {l, update(node)};
+		} else {
+			auto [l, r] = split(node->right, count - sizeOf(node->left) - 1);
+			node->right = l;
+			return {update(node), r};
+		}
+	}
+
+	static Node* merge(Node* l, Node* r)
+	{
+		if (!l) return r;
+		if (!r) return l;
+		if (r->priority < l->priority) {
+			l->right = merge(l->right, r);
+			return update(l);
+		} else {
+			r->left = merge(l, r->left);
+			return update(r);
+		}
+	}
+
+	static void destroy(Node* node)
+	{
+		if (!node) {
+			return;
+		}
+		destroy(node->left);
+		destroy(node->right);
+		delete node;
+	}
+
+	template <typename N>
+	static N* leftmost(N* node)
+	{
+		while (node && node->left) {
+			node = node->left;
+		}
+		return node;
+	}
+	template <typename N>
+	static N* rightmost(N* node)
+	{
+		while (node && node->right) {
+			node = node->right;
+		}
+		return node;
+	}
+	template <typename N>
+	static N* successor(N* node)
+	{
+		if (node->right) {
+			return leftmost(node->right);
+		}
+		while (node->parent && node == node->parent->right) {
+			node = node->parent;
+		}
+		return node->parent;
+	}
+	template <typename N>
+	static N* predecessor(N* node)
+	{
+		if (node->left) {
+			return rightmost(node->left);
+		}
+		while (node->parent && node == node->parent->left) {
+			node = node->parent;
+		}
+		return node->parent;
+	}
+
+	static std::size_t rank(const Node* node)
+	{
+		std::size_t res = sizeOf(node->left);
+		for (; node->parent; node = node->parent) {
+			if (node == node->parent->right) {
+				res += sizeOf(node->parent->left) + 1;
+			}
+		}
+		return res;
+	}
+
+	Node* nodeAt(std::size_t pos) const
+	{
+		Node* node = root;
+		while (node) {
+			const auto leftSize = sizeOf(node->left);
+			if (pos < leftSize) {
+				node = node->left;
+			} else if (pos == leftSize) {
+				return node;
+			} else {
+				pos -= leftSize + 1;
+				node = node->right;
+			}
+		}
+		return nullptr;
+	}
+
+	Node* detach(std::size_t pos)
+	{
+		auto [l, rest] = split(root, pos);
+		auto [node, r] = split(rest, 1);
+		setRoot(merge(l, r));
+		if (node) {
+			node->parent = nullptr;
+		}
+		return node;
+	}
+
+	void setRoot(Node* node)
+	{
+		root = node;
+		if (root) {
+			root->parent = nullptr;
+		}
+	}
+
+	std::uint32_t nextPriority()
+	{
+		// xorshift32, good enough for balancing
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+
+private:
+	Node* root = nullptr;
+	std::uint32_t seed = 2463534242u;
+};
+
+} // namespace iplayer
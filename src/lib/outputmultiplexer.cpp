@@ -0,0 +1,262 @@
+#include "outputmultiplexer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace iplayer
+{
+
+/* Single-producer single-consumer ring of records: [std::uint32_t size][bytes]. */
+class OutputMultiplexer::Ring
+{
+public:
+	Ring(std::size_t capacity, OverflowPolicy policy) :
+		data(std::bit_ceil(std::max<std::size_t>(capacity, 64))),
+		policy(policy)
+	{}
+
+	std::size_t maxRecordSize() const { return data.size() - sizeof(std::uint32_t); }
+	OverflowPolicy getPolicy() const { return policy; }
+
+	// Producer side; `record.size()` should not exceed maxRecordSize().
+	bool push(std::string_view record)
+	{
+		const std::uint32_t size = static_cast<std::uint32_t>(record.size());
+		const auto needed = sizeof(size) + size;
+		const auto h = head.load(std::memory_order_relaxed);
+		for (auto t = tail.load(std::memory_order_acquire); data.size() - (h - t) < needed;
+		     t = tail.load(std::memory_order_acquire)) {
+			if (policy == OverflowPolicy::Drop) {
+				drop();
+				return false;
+			}
+			tail.wait(t, std::memory_order_acquire);
+		}
+		copyIn(h, reinterpret_cast<const char*>(&size), sizeof(size));
+		copyIn(h + sizeof(size), record.data(), size);
+		head.store(h + needed, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side: append all committed records to `out`.
+	void popAll(std::string& out)
+	{
+		auto t = tail.load(std::memory_order_relaxed);
+		const auto h = head.load(std::memory_order_acquire);
+		if (t == h) {
+			return;
+		}
+		while (t != h) {
+			std::uint32_t size;
+			copyOut(t, reinterpret_cast<char*>(&size), sizeof(size));
+			const auto offset = out.size();
+			out.resize(offset + size);
+			copyOut(t + sizeof(size), out.data() + offset, size);
+			t += sizeof(size) + size;
+		}
+		tail.store(t, std::memory_order_release);
+		tail.notify_all();
+	}
+
+	std::size_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+	void drop() { dropped.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+	void copyIn(std::uint64_t pos, const char* s, std::size_t size)
+	{
+		const auto offset = pos & (data.size() - 1);
+		const auto first = std::min(size, data.size() - offset);
+		std::memcpy(data.data() + offset, s, first);
+		std::memcpy(data.data(), s + first, size - first);
+	}
+	void copyOut(std::uint64_t pos, char* s, std::size_t size) const
+	{
+		const auto offset = pos & (data.size() - 1);
+		const auto first = std::min(size, data.size() - offset);
+		std::memcpy(s, data.data() + offset, first);
+		std::memcpy(s + first, data.data(), size - first);
+	}
+
+private:
+	std::vector<char> data; // power of 2 size
+	const OverflowPolicy policy;
+	std::atomic<std::uint64_t> head = 0; // written by the producer
+	std::atomic<std::uint64_t> tail = 0; // written by the writer thread
+	std::atomic<std::size_t> dropped = 0;
+};
+
+/* Accumulate characters, and commit complete lines to the ring. */
+class OutputMultiplexer::Buffer : public std::streambuf
+{
+public:
+	Buffer(OutputMultiplexer& multiplexer, Ring& ring) : multiplexer(multiplexer), ring(ring) {}
+	~Buffer() override { multiplexer.removeRing(ring); }
+
+protected:
+	int_type overflow(int_type c) override
+	{
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			pending += traits_type::to_char_type(c);
+			if (c == '\n') {
+				commit(pending.size());
+			}
+		}
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char* s, std::streamsize n) override
+	{
+		pending.append(s, static_cast<std::size_t>(n));
+		const auto lastNewline = pending.rfind('\n');
+		if (lastNewline != std::string::npos && pending.size() - n <= lastNewline) {
+			commit(lastNewline + 1);
+		}
+		return n;
+	}
+
+	int sync() override
+	{
+		commit(pending.size());
+		return 0;
+	}
+
+private:
+	// Whole lines are packed into records fitting in the ring. A line longer than the ring is
+	// dropped with the Drop policy, split with the Block one (so its parts might be interleaved).
+	// The writer is notified of each record: pushing the next may wait for it to drain the ring.
+	void commit(std::size_t size)
+	{
+		const auto maxSize = ring.maxRecordSize();
+		std::string_view rest(pending.data(), size);
+		while (!rest.empty()) {
+			auto fitting = rest.size();
+			if (maxSize < fitting) {
+				const auto lastNewline = rest.rfind('\n', maxSize - 1);
+				fitting = lastNewline == std::string_view::npos ? 0 : lastNewline + 1;
+			}
+			if (fitting != 0) {
+				push(rest.substr(0, fitting));
+				rest.remove_prefix(fitting);
+				continue;
+			}
+			const auto line = rest.substr(0, std::min(rest.find('\n'), rest.size() - 1) + 1);
+			if (ring.getPolicy() == OverflowPolicy::Drop) {
+				ring.drop();
+			} else {
+				for (std::size_t i = 0; i < line.size(); i += maxSize) {
+					push(line.substr(i, maxSize));
+				}
+			}
+			rest.remove_prefix(line.size());
+		}
+		pending.erase(0, size);
+	}
+
+	void push(std::string_view record)
+	{
+		ring.push(record);
+		multiplexer.notifyWriter();
+	}
+
+private:
+	OutputMultiplexer& multiplexer;
+	Ring& ring;
+	std::string pending;
+};
+
+//------------------------------------------------------------------------------
+OutputMultiplexer::OutputStream::OutputStream(std::unique_ptr<Buffer> buffer) :
+	std::ostream(buffer.get()),
+	buffer(std::move(buffer))
+{}
+
+//------------------------------------------------------------------------------
+OutputMultiplexer::OutputStream::~OutputStream()
+{
+	flush();
+}
+
+//------------------------------------------------------------------------------
+OutputMultiplexer::OutputMultiplexer(std::ostream& sink, std::size_t ringCapacity) :
+	sink(sink),
+	ringCapacity(ringCapacity)
+{
+	thread = std::thread([this]() { run(); });
+}
+
+//------------------------------------------------------------------------------
+OutputMultiplexer::~OutputMultiplexer()
+{
+	stopping = true;
+	notifyWriter();
+	thread.join();
+}
+
+//------------------------------------------------------------------------------
+auto OutputMultiplexer::createStream(OverflowPolicy policy) -> std::unique_ptr<OutputStream>
+{
+	std::lock_guard l(mutex);
+	rings.push_back(std::make_unique<Ring>(ringCapacity, policy));
+	return std::unique_ptr<OutputStream>(
+		new OutputStream(std::make_unique<Buffer>(*this, *rings.back())));
+}
+
+//------------------------------------------------------------------------------
+// Keep the records of the ring for the writer, and release it.
+void OutputMultiplexer::removeRing(Ring& ring)
+{
+	{
+		std::lock_guard l(mutex);
+		ring.popAll(orphans);
+		droppedByRemoved += ring.getDroppedCount();
+		std::erase_if(rings, [&](const auto& r) { return r.get() == &ring; });
+	}
+	notifyWriter();
+}
+
+//------------------------------------------------------------------------------
+std::size_t OutputMultiplexer::getDroppedCount() const
+{
+	std::lock_guard l(mutex);
+	std::size_t res = droppedByRemoved;
+	for (const auto& ring : rings) {
+		res += ring->getDroppedCount();
+	}
+	return res;
+}
+
+//------------------------------------------------------------------------------
+void OutputMultiplexer::notifyWriter()
+{
+	published.fetch_add(1, std::memory_order_release);
+	published.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void OutputMultiplexer::run()
+{
+	std::string batch;
+	while (true) {
+		const auto seen = published.load(std::memory_order_acquire);
+		const bool stop = stopping; // read before the last gathering
+		batch.clear();
+		{
+			std::lock_guard l(mutex);
+			batch.swap(orphans);
+			for (auto& ring : rings) {
+				ring->popAll(batch);
+			}
+		}
+		if (!batch.empty()) {
+			sink.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+			sink.flush();
+		} else if (stop) {
+			return;
+		} else {
+			published.wait(seen, std::memory_order_acquire);
+		}
+	}
+}
+
+} // namespace iplayer
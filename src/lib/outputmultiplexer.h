@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace iplayer
+{
+
+/* Share one output stream (typically std::cout) between threads.
+   Each producer writes to its own OutputStream, backed by a lock-free single-producer ring
+   buffer, released with the stream; complete lines are committed as a whole (or everything on
+   flush).
+   A single writer thread gathers committed records from all rings and writes them to the sink
+   by batches, so lines never interleave, and a slow sink does not stall producers
+   (unless they choose to block). */
+class OutputMultiplexer
+{
+public:
+	enum class OverflowPolicy
+	{
+		Drop, // lose the record when the ring is full (e.g. for real-time output)
+		Block // wait for the writer
+	};
+	class OutputStream;
+
+	explicit OutputMultiplexer(std::ostream& sink, std::size_t ringCapacity = 64 * 1024);
+	~OutputMultiplexer(); // write all committed records; streams should be destroyed before
+
+	OutputMultiplexer(const OutputMultiplexer&) = delete;
+	OutputMultiplexer& operator=(const OutputMultiplexer&) = delete;
+
+	// To use from a single thread at a time.
+	std::unique_ptr<OutputStream> createStream(OverflowPolicy);
+
+	std::size_t getDroppedCount() const;
+
+private:
+	class Ring;
+	class Buffer;
+
+	void removeRing(Ring&);
+	void notifyWriter();
+	void run();
+
+private:
+	std::ostream& sink;
+	const std::size_t ringCapacity;
+	mutable std::mutex mutex; // for rings, not taken by producers
+	std::vector<std::unique_ptr<Ring>> rings; // of live streams
+	std::string orphans; // records left by destroyed streams
+	std::size_t droppedByRemoved = 0; // by destroyed streams
+	std::atomic<std::uint64_t> published = 0; // wakes the writer up
+	std::atomic<bool> stopping = false;
+	std::thread thread;
+};
+
+class OutputMultiplexer::OutputStream : public std::ostream
+{
+public:
+	~OutputStream() override;
+
+private:
+	friend class OutputMultiplexer;
+	explicit OutputStream(std::unique_ptr<Buffer>);
+
+private:
+	std::unique_ptr<Buffer> buffer;
+};
+
+} // namespace iplayer
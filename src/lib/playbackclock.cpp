@@ -0,0 +1,93 @@
+#include "playbackclock.h"
+
+#include <algorithm>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+std::int64_t toNs(std::chrono::steady_clock::time_point t)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+PlaybackClock::State PlaybackClock::read() const
+{
+	while (true) {
+		const auto before = sequence.load(std::memory_order_acquire);
+		const State res{originNs.load(std::memory_order_relaxed),
+		                startNs.load(std::memory_order_relaxed)};
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (before % 2 == 0 && before == sequence.load(std::memory_order_relaxed)) {
+			return res;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void PlaybackClock::write(const State& state)
+{
+	const auto s = sequence.load(std::memory_order_relaxed);
+	sequence.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	originNs.store(state.origin, std::memory_order_relaxed);
+	startNs.store(state.start, std::memory_order_relaxed);
+	sequence.store(s + 2, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+std::chrono::nanoseconds PlaybackClock::getPosition(Clock::time_point now) const
+{
+	const auto state = read();
+	if (state.start == notRunning) {
+		return std::chrono::nanoseconds(state.origin);
+	}
+	return std::chrono::nanoseconds(state.origin + std::max<std::int64_t>(0, toNs(now) - state.start));
+}
+
+//------------------------------------------------------------------------------
+bool PlaybackClock::isRunning() const
+{
+	return read().start != notRunning;
+}
+
+//------------------------------------------------------------------------------
+PlaybackClock::Clock::time_point PlaybackClock::timeAt(std::chrono::nanoseconds target) const
+{
+	const auto state = read();
+	if (state.start == notRunning) {
+		return Clock::time_point::max();
+	}
+	return Clock::time_point(std::chrono::nanoseconds(state.start + (target.count() - state.origin)));
+}
+
+//------------------------------------------------------------------------------
+void PlaybackClock::start(Clock::time_point now)
+{
+	const auto state = read();
+	if (state.start == notRunning) {
+		write({state.origin, toNs(now)});
+	}
+}
+
+//------------------------------------------------------------------------------
+void PlaybackClock::pause(Clock::time_point now)
+{
+	if (isRunning()) {
+		write({getPosition(now).count(), notRunning});
+	}
+}
+
+//------------------------------------------------------------------------------
+void PlaybackClock::seek(std::chrono::nanoseconds position, Clock::time_point now)
+{
+	write({position.count(), isRunning() ? toNs(now) : notRunning});
+}
+
+} // namespace iplayer
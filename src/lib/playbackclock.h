@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace iplayer
+{
+
+/* Playback position derived from steady_clock timestamps:
+   `origin + (now - start)` while running, `origin` while paused.
+   Nothing accumulates, so the position stays exact over hours.
+   Readers never lock (seqlock); writers must be serialized by the caller. */
+class PlaybackClock
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	std::chrono::nanoseconds getPosition(Clock::time_point now = Clock::now()) const;
+	bool isRunning() const;
+	// Time at which the position reaches `target` (if running and not seeked before).
+	Clock::time_point timeAt(std::chrono::nanoseconds target) const;
+	// Changed by each write.
+	std::uint32_t getVersion() const { return sequence.load(std::memory_order_acquire); }
+
+	void start(Clock::time_point now = Clock::now());
+	void pause(Clock::time_point now = Clock::now());
+	void seek(std::chrono::nanoseconds, Clock::time_point now = Clock::now());
+
+private:
+	static constexpr std::int64_t notRunning = std::numeric_limits<std::int64_t>::min();
+
+	struct State
+	{
+		std::int64_t origin; // position in ns
+		std::int64_t start; // steady_clock ns at which position was origin, or notRunning
+	};
+	State read() const;
+	void write(const State&);
+
+private:
+	std::atomic<std::uint32_t> sequence = 0; // odd while writing
+	std::atomic<std::int64_t> originNs = 0;
+	std::atomic<std::int64_t> startNs = notRunning;
+};
+
+} // namespace iplayer
@@ -0,0 +1,297 @@
+#include "playbackengine.h"
+
+#include <algorithm>
+
+namespace iplayer
+{
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+template <typename Link>
+bool isLinked(const Link& link)
+{
+	return link.next != &link;
+}
+
+//------------------------------------------------------------------------------
+template <typename Link>
+void unlink(Link& link)
+{
+	link.prev->next = link.next;
+	link.next->prev = link.prev;
+	link.prev = &link;
+	link.next = &link;
+}
+
+//------------------------------------------------------------------------------
+template <typename Link>
+void pushBack(Link& list, Link& link)
+{
+	link.prev = list.prev;
+	link.next = &list;
+	list.prev->next = &link;
+	list.prev = &link;
+}
+
+//------------------------------------------------------------------------------
+// Move all the links of `from` to the end of `to`.
+template <typename Link>
+void splice(Link& to, Link& from)
+{
+	if (!isLinked(from)) {
+		return;
+	}
+	from.next->prev = to.prev;
+	to.prev->next = from.next;
+	from.prev->next = &to;
+	to.prev = from.prev;
+	from.prev = &from;
+	from.next = &from;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+PlaybackEngine::PlaybackEngine(std::size_t threadCount, std::chrono::nanoseconds resolution) :
+	resolution(std::max(resolution, std::chrono::nanoseconds(1))),
+	epoch(Clock::now()),
+	simulated(threadCount == 0),
+	simulatedTime(0)
+{
+	for (std::size_t i = 0; i != threadCount; ++i) {
+		threads.emplace_back([this]() { run(); });
+	}
+}
+
+//------------------------------------------------------------------------------
+PlaybackEngine::~PlaybackEngine()
+{
+	{
+		std::lock_guard l{mutex};
+		stopping = true;
+	}
+	workCv.notify_all();
+	tickCv.notify_all();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+//------------------------------------------------------------------------------
+void PlaybackEngine::schedule(Timer& timer, Clock::time_point deadline)
+{
+	std::lock_guard l{mutex};
+	remove(timer);
+	if (armedCount == 0) {
+		// Nothing to cascade: skip the ticks elapsed while idle.
+		nextTick = std::max(nextTick, getElapsedTick());
+	}
+	timer.expiry = std::max(tickOf(deadline), nextTick);
+	insert(timer);
+	++armedCount;
+	if (hasTickWaiter && (!tickWaiterTarget || timer.expiry < *tickWaiterTarget)) {
+		tickCv.notify_one();
+	}
+}
+
+//------------------------------------------------------------------------------
+void PlaybackEngine::cancel(Timer& timer)
+{
+	std::lock_guard l{mutex};
+	remove(timer);
+}
+
+//------------------------------------------------------------------------------
+void PlaybackEngine::cancelAndWait(Timer& timer)
+{
+	std::unique_lock l{mutex};
+	remove(timer);
+	runCv.wait(l, [&]() { return !timer.running; });
+}
+
+//------------------------------------------------------------------------------
+PlaybackEngine::Clock::time_point PlaybackEngine::now() const
+{
+	if (simulated) {
+		return epoch + Clock::duration(simulatedTime.load(std::memory_order_acquire));
+	}
+	return Clock::now();
+}
+
+//------------------------------------------------------------------------------
+void PlaybackEngine::runUntil(Clock::time_point t)
+{
+	std::unique_lock l{mutex};
+	if (!simulated) {
+		return;
+	}
+	simulatedTime.store(std::max((t - epoch).count(), simulatedTime.load()),
+	                    std::memory_order_release);
+	while (true) {
+		if (isLinked(ready)) {
+			runReady(l);
+		} else if (armedCount != 0 && nextTick <= getElapsedTick()) {
+			advance(getElapsedTick());
+		} else {
+			return;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+std::uint64_t PlaybackEngine::tickOf(Clock::time_point t) const
+{
+	if (t <= epoch) {
+		return 0;
+	}
+	return static_cast<std::uint64_t>((t - epoch + resolution - std::chrono::nanoseconds(1))
+	                                  / resolution);
+}
+
+//------------------------------------------------------------------------------
+// Last tick whose time is reached.
+std::uint64_t PlaybackEngine::getElapsedTick() const
+{
+	return static_cast<std::uint64_t>((now() - epoch) / resolution);
+}
+
+//------------------------------------------------------------------------------
+PlaybackEngine::Clock::time_point PlaybackEngine::timeOf(std::uint64_t tick) const
+{
+	return epoch + tick * resolution;
+}
+
+//------------------------------------------------------------------------------
+// First slot of level 0 to process, or the next cascade; nullopt if no timer is armed.
+std::optional<std::uint64_t> PlaybackEngine::getNextWakeTick() const
+{
+	if (armedCount == 0) {
+		return std::nullopt;
+	}
+	for (auto tick = nextTick; tick == nextTick || tick % slotCount != 0; ++tick) {
+		if (isLinked(wheel[0][tick % slotCount])) {
+			return tick;
+		}
+	}
+	return (nextTick / slotCount + 1) * slotCount;
+}
+
+//------------------------------------------------------------------------------
+// `timer.expiry` is not before `nextTick`.
+void PlaybackEngine::insert(Timer& timer)
+{
+	// Farther timers wait in the last level, and are inserted again when cascaded.
+	const auto delta = std::min<std::uint64_t>(timer.expiry - nextTick,
+	                                           (std::uint64_t(1) << (levelBits * levelCount)) - 1);
+	std::size_t level = 0;
+	while (delta >> (levelBits * (level + 1)) != 0) {
+		++level;
+	}
+	const auto slot = ((nextTick + delta) >> (levelBits * level)) % slotCount;
+	pushBack<Link>(wheel[level][slot], timer);
+}
+
+//------------------------------------------------------------------------------
+// Unlink the timer from the wheel or from the ready list.
+void PlaybackEngine::remove(Timer& timer)
+{
+	timer.runAgain = false;
+	if (!isLinked<Link>(timer)) {
+		return;
+	}
+	if (timer.expiry >= nextTick) { // in the wheel
+		--armedCount;
+	}
+	unlink<Link>(timer);
+}
+
+//------------------------------------------------------------------------------
+void PlaybackEngine::cascade(std::size_t level, std::size_t slot)
+{
+	Link timers;
+	splice(timers, wheel[level][slot]);
+	while (isLinked(timers)) {
+		auto& timer = static_cast<Timer&>(*timers.next);
+		unlink<Link>(timer);
+		insert(timer);
+	}
+}
+
+//------------------------------------------------------------------------------
+void PlaybackEngine::advance(std::uint64_t nowTick)
+{
+	for (; nextTick <= nowTick; ++nextTick) {
+		for (std::size_t level = 1; level != levelCount; ++level) {
+			if ((nextTick >> (levelBits * (level - 1))) % slotCount != 0) {
+				break;
+			}
+			cascade(level, (nextTick >> (levelBits * level)) % slotCount);
+		}
+		auto& slot = wheel[0][nextTick % slotCount];
+		while (isLinked(slot)) {
+			auto& timer = static_cast<Timer&>(*slot.next);
+			unlink<Link>(timer);
+			pushBack<Link>(ready, timer);
+			--armedCount;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Run the first ready timer, or defer it if it is already running.
+void PlaybackEngine::runReady(std::unique_lock<std::mutex>& l)
+{
+	auto& timer = static_cast<Timer&>(*ready.next);
+	unlink<Link>(timer);
+	if (timer.running) {
+		timer.runAgain = true;
+		return;
+	}
+	timer.running = true;
+	if (isLinked(ready) && !simulated) {
+		workCv.notify_one();
+	}
+	l.unlock();
+	timer.onTimer();
+	l.lock();
+	timer.running = false;
+	if (timer.runAgain) {
+		timer.runAgain = false;
+		pushBack<Link>(ready, timer);
+	}
+	runCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+void PlaybackEngine::run()
+{
+	std::unique_lock l{mutex};
+	while (!stopping) {
+		if (isLinked(ready)) {
+			runReady(l);
+			continue;
+		}
+		if (armedCount != 0 && nextTick <= getElapsedTick()) {
+			advance(getElapsedTick());
+			continue;
+		}
+		if (hasTickWaiter) {
+			workCv.wait(l);
+			continue;
+		}
+		// Wait for the next tick, while the others run the due timers.
+		hasTickWaiter = true;
+		tickWaiterTarget = getNextWakeTick();
+		if (tickWaiterTarget) {
+			tickCv.wait_until(l, timeOf(*tickWaiterTarget));
+		} else {
+			tickCv.wait(l);
+		}
+		hasTickWaiter = false;
+		workCv.notify_one(); // so that a thread waits for the next tick while this one works
+	}
+}
+
+} // namespace iplayer
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace iplayer
+{
+
+/* Timers of any number of players, serviced by a small fixed pool of threads.
+   Timers are kept in a hierarchical timer wheel (4 levels of 64 slots): arming, moving and
+   cancelling a timer is O(1), and the pool only wakes up for due slots or level cascades.
+   One thread at a time waits for the next tick and advances the wheel; due timers are run by
+   any thread of the pool. A given timer never runs on two threads at once: if it becomes due
+   while running (re-armed by its own run), it runs again once the current run is over.
+   Without threads, the engine is driven by runUntil(), on a simulated time. */
+class PlaybackEngine
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	class Timer;
+
+	explicit PlaybackEngine(std::size_t threadCount = 2,
+	                        std::chrono::nanoseconds resolution = std::chrono::milliseconds(1));
+	~PlaybackEngine(); // timers must be cancelled before
+
+	PlaybackEngine(const PlaybackEngine&) = delete;
+	PlaybackEngine& operator=(const PlaybackEngine&) = delete;
+
+	// Arm (or move) the timer: it runs once at, or after, `deadline`.
+	void schedule(Timer&, Clock::time_point deadline);
+	// Disarm the timer; if it is running, it may still be running after the call.
+	void cancel(Timer&);
+	// Disarm the timer and wait for the end of its run (not to be called from it).
+	void cancelAndWait(Timer&);
+
+	// Current time of the engine: steady_clock time, or the simulated one without threads.
+	Clock::time_point now() const;
+	// Without threads only: set the simulated time and run the timers due, on this thread.
+	void runUntil(Clock::time_point);
+
+private:
+	struct Link
+	{
+		Link* prev = this;
+		Link* next = this;
+	};
+	static constexpr std::size_t levelBits = 6;
+	static constexpr std::size_t slotCount = 1 << levelBits;
+	static constexpr std::size_t levelCount = 4;
+
+	std::uint64_t tickOf(Clock::time_point) const; // rounded up
+	std::uint64_t getElapsedTick() const;
+	Clock::time_point timeOf(std::uint64_t tick) const;
+	std::optional<std::uint64_t> getNextWakeTick() const;
+	void insert(Timer&); // with lock
+	void remove(Timer&); // with lock
+	void cascade(std::size_t level, std::size_t slot); // with lock
+	void advance(std::uint64_t nowTick); // with lock
+	void runReady(std::unique_lock<std::mutex>&);
+	void run();
+
+private:
+	const std::chrono::nanoseconds resolution;
+	const Clock::time_point epoch;
+	const bool simulated; // no thread
+	std::atomic<Clock::rep> simulatedTime; // since epoch
+	std::mutex mutex;
+	std::condition_variable workCv; // ready timers, or no thread waiting for the next tick
+	std::condition_variable tickCv; // for the thread waiting for the next tick
+	std::condition_variable runCv; // a timer run ended
+	std::array<std::array<Link, slotCount>, levelCount> wheel;
+	Link ready; // due timers, in order
+	std::size_t armedCount = 0; // timers in the wheel
+	std::uint64_t nextTick = 0; // next one to process
+	bool hasTickWaiter = false;
+	std::optional<std::uint64_t> tickWaiterTarget;
+	bool stopping = false;
+	std::vector<std::thread> threads;
+};
+
+/* Intrusive timer: armed timers cost no allocation. */
+class PlaybackEngine::Timer : private PlaybackEngine::Link
+{
+public:
+	Timer() = default;
+	virtual ~Timer() = default;
+
+	Timer(const Timer&) = delete;
+	Timer& operator=(const Timer&) = delete;
+
+protected:
+	// Run on a thread of the pool, without any lock of the engine.
+	virtual void onTimer() = 0;
+
+private:
+	friend class PlaybackEngine;
+
+	std::uint64_t expiry = 0; // tick, at least the engine `nextTick` while in the wheel
+	bool running = false;
+	bool runAgain = false; // became due while running
+};
+
+} // namespace iplayer
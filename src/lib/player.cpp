@@ -1,32 +1,30 @@
 #include "player.h"
 
+#include "trackmetadata.h"
+
 #include <algorithm>
 #include <cassert>
-#include <random>
+#include <limits>
 
 namespace
 {
 //------------------------------------------------------------------------------
-std::size_t rand_in(std::size_t lower, std::size_t upper)
+template <typename... Fs>
+struct Overloaded : Fs...
 {
-	static thread_local std::default_random_engine rnd{std::random_device()()};
-	return std::uniform_int_distribution<std::size_t>{lower, upper}(rnd);
-}
+	using Fs::operator()...;
+};
 
 //------------------------------------------------------------------------------
-std::optional<std::size_t> pos_by_id(const iplayer::Playlist& playlist, std::size_t id)
+// Tracks may be added with relative paths, while watchers report absolute ones.
+std::filesystem::path normalizedPath(const std::filesystem::path& path)
 {
-	auto it =
-		std::ranges::find_if(playlist.getTracks(), [&](const auto& p) { return p.first == id; });
-
-	if (it != playlist.getTracks().end()) {
-		return std::distance(playlist.getTracks().begin(), it);
-	} else {
-		return std::nullopt;
-	}
+	std::error_code ec;
+	return std::filesystem::absolute(path, ec).lexically_normal();
 }
 
 } // namespace
+
 namespace iplayer
 {
 
@@ -36,6 +34,8 @@ Player::Player(std::shared_ptr<IMusicPlayer> musicPlayer, Playlist&& playlist) :
 	displayedPlaylist(std::move(playlist)),
 	randomOrderPlaylist(displayedPlaylist)
 {
+	publishSnapshot();
+	reindexPaths();
 	this->musicPlayer->setOnMusicFinished([this]() {
 		next();
 		if (onMusicChanged) {
@@ -100,6 +100,7 @@ void Player::previous()
 	} else {
 		previous(displayedPlaylist, currentSelectionIndex);
 	}
+	prefetchNext();
 }
 
 //------------------------------------------------------------------------------
@@ -108,15 +109,19 @@ void Player::previous(Playlist& playlist, std::optional<std::size_t>& optIndex)
 	std::lock_guard l(mutex);
 
 	const bool wasPlaying = playing;
+	const bool hadSelection = optIndex.has_value();
 	stop();
 	if (playlist.getTracks().empty()) {
 		return;
 	}
+	if (!optIndex && randomModeActivated) {
+		// A lazy permutation has no last track until fully drawn: start one as next() does.
+		playing = wasPlaying;
+		next(playlist, optIndex);
+		return;
+	}
 	if (!optIndex) {
-		if (randomModeActivated) {
-			prepareRandomMode();
-		}
-		if (musicPlayer->openMusic(playlist.getTracks().back().second.filename)) {
+		if (open(playlist.getTracks().back().second)) {
 			optIndex = playlist.getTracks().size() - 1;
 			if (wasPlaying) {
 				play();
@@ -127,7 +132,7 @@ void Player::previous(Playlist& playlist, std::optional<std::size_t>& optIndex)
 	auto index = optIndex.value_or(playlist.getTracks().size() - 1);
 	while (index != 0) {
 		--index;
-		if (musicPlayer->openMusic(playlist.getTracks()[index].second.filename)) {
+		if (open(playlist.getTracks()[index].second)) {
 			optIndex = index;
 			if (wasPlaying) {
 				play();
@@ -135,7 +140,7 @@ void Player::previous(Playlist& playlist, std::optional<std::size_t>& optIndex)
 			return;
 		}
 	}
-	if (repeatModeActivated) {
+	if (repeatModeActivated && hadSelection) { // else, no playable track at all
 		optIndex.reset();
 		playing = wasPlaying;
 		previous(playlist, optIndex);
@@ -152,6 +157,7 @@ void Player::next()
 	} else {
 		next(displayedPlaylist, currentSelectionIndex);
 	}
+	prefetchNext();
 }
 
 //------------------------------------------------------------------------------
@@ -159,6 +165,7 @@ void Player::next(Playlist& playlist, std::optional<std::size_t>& optIndex)
 {
 	std::lock_guard l(mutex);
 	const bool wasPlaying = playing;
+	const bool hadSelection = optIndex.has_value();
 	stop();
 	if (playlist.getTracks().empty()) {
 		return;
@@ -167,7 +174,8 @@ void Player::next(Playlist& playlist, std::optional<std::size_t>& optIndex)
 		if (randomModeActivated) {
 			prepareRandomMode();
 		}
-		if (musicPlayer->openMusic(playlist.getTracks()[0].second.filename)) {
+		playlist.draw(0);
+		if (open(playlist.getTracks()[0].second)) {
 			optIndex = 0;
 			if (wasPlaying) {
 				play();
@@ -178,7 +186,8 @@ void Player::next(Playlist& playlist, std::optional<std::size_t>& optIndex)
 	auto index = optIndex.value_or(0);
 	while (index < playlist.getTracks().size() - 1) {
 		++index;
-		if (musicPlayer->openMusic(playlist.getTracks()[index].second.filename)) {
+		playlist.draw(index);
+		if (open(playlist.getTracks()[index].second)) {
 			optIndex = index;
 			if (wasPlaying) {
 				play();
@@ -186,7 +195,7 @@ void Player::next(Playlist& playlist, std::optional<std::size_t>& optIndex)
 			return;
 		}
 	}
-	if (repeatModeActivated) {
+	if (repeatModeActivated && hadSelection) { // else, no playable track at all
 		optIndex.reset();
 		playing = wasPlaying;
 		next(playlist, optIndex);
@@ -203,11 +212,12 @@ void Player::select(std::size_t n)
 	const bool wasPlaying = playing;
 	stop();
 	n = std::clamp(n, std::size_t(0), displayedPlaylist.getTracks().size());
-	if (musicPlayer->openMusic(displayedPlaylist.getTracks()[n].second.filename)) {
+	if (open(displayedPlaylist.getTracks()[n].second)) {
 		currentSelectionIndex = n;
 		if (randomModeActivated) {
 			prepareRandomMode();
 		}
+		prefetchNext();
 		if (wasPlaying) {
 			play();
 		}
@@ -218,16 +228,53 @@ void Player::select(std::size_t n)
 void Player::prepareRandomMode()
 {
 	std::lock_guard l(mutex);
-	randomOrderPlaylist.shuffle();
 	if (currentSelectionIndex) {
 		const auto& [id, track] = displayedPlaylist.getTracks()[*currentSelectionIndex];
-		auto pos = pos_by_id(randomOrderPlaylist, id);
+		auto pos = randomOrderPlaylist.positionOf(id);
 		if (pos) {
 			randomOrderPlaylist.move(*pos, 0);
+			randomOrderPlaylist.shuffleLazily(1);
 			currentRandomSelectionIndex = 0;
+			return;
+		}
+	}
+	randomOrderPlaylist.shuffleLazily();
+	currentRandomSelectionIndex.reset();
+}
+
+//------------------------------------------------------------------------------
+bool Player::open(const TrackRef& track)
+{
+	return !unplayableTracks.contains(track->filename) && musicPlayer->openMusic(track->filename);
+}
+
+//------------------------------------------------------------------------------
+// Hint the music player with the track next() would open.
+void Player::prefetchNext()
+{
+	auto& playlist = randomModeActivated ? randomOrderPlaylist : displayedPlaylist;
+	const auto& optIndex = randomModeActivated ? currentRandomSelectionIndex : currentSelectionIndex;
+	const auto size = playlist.getTracks().size();
+	if (!optIndex) {
+		return;
+	}
+	for (auto index = *optIndex + 1;; ++index) {
+		if (index == size) {
+			// Random order is reshuffled when repeated.
+			if (!repeatModeActivated || randomModeActivated) {
+				return;
+			}
+			index = 0;
+		}
+		if (index == *optIndex) {
+			return;
+		}
+		playlist.draw(index);
+		const auto& track = playlist.getTracks()[index].second;
+		if (!unplayableTracks.contains(track->filename)) {
+			musicPlayer->prefetch(track->filename);
+			return;
 		}
-	} else {
-		currentRandomSelectionIndex.reset();
 	}
 }
 
@@ -251,66 +298,120 @@ void Player::setRepeatMode(bool value)
 //------------------------------------------------------------------------------
 void Player::push_back(TrackHeader&& track)
 {
-	std::lock_guard l(mutex);
-	displayedPlaylist.push_back(TrackHeader(track));
-	randomOrderPlaylist.push_back(std::move(track));
-	if (randomModeActivated && currentRandomSelectionIndex) {
-		randomOrderPlaylist.move(
-			randomOrderPlaylist.getTracks().size() - 1,
-			rand_in(*currentSelectionIndex + 1, randomOrderPlaylist.getTracks().size() - 1));
-	}
+	std::vector<PlaylistEdit> edits;
+	edits.emplace_back(edit::Append{std::move(track)}); // initializer_list would copy
+	applyBatch(std::move(edits));
 }
 //------------------------------------------------------------------------------
 void Player::insertAt(std::size_t pos, TrackHeader&& track)
 {
-	std::lock_guard l(mutex);
-	displayedPlaylist.insertAt(pos, TrackHeader(track));
-	if (currentSelectionIndex && pos <= currentSelectionIndex) {
-		++*currentSelectionIndex;
-	}
-	randomOrderPlaylist.push_back(std::move(track));
-	if (randomModeActivated && currentRandomSelectionIndex) {
-		randomOrderPlaylist.move(
-			randomOrderPlaylist.getTracks().size() - 1,
-			rand_in(*currentSelectionIndex + 1, randomOrderPlaylist.getTracks().size() - 1));
+	std::vector<PlaylistEdit> edits;
+	edits.emplace_back(edit::Insert{pos, std::move(track)});
+	applyBatch(std::move(edits));
+}
+//------------------------------------------------------------------------------
+void Player::append(std::span<TrackHeader> tracks)
+{
+	insertRange(std::numeric_limits<std::size_t>::max(), tracks);
+}
+//------------------------------------------------------------------------------
+void Player::insertRange(std::size_t pos, std::span<TrackHeader> tracks)
+{
+	edit::InsertRange e{pos, {}};
+	e.tracks.reserve(tracks.size());
+	for (auto& track : tracks) {
+		e.tracks.push_back(TrackStore::global().intern(std::move(track)));
 	}
+	std::vector<PlaylistEdit> edits;
+	edits.emplace_back(std::move(e));
+	applyBatch(std::move(edits));
 }
 //------------------------------------------------------------------------------
 void Player::remove(std::size_t pos)
 {
-	std::lock_guard l(mutex);
-
-	pos = std::clamp(pos, std::size_t(0), displayedPlaylist.getTracks().size());
-	auto id = displayedPlaylist.getTracks()[pos].first;
-	displayedPlaylist.remove(pos);
-	if (currentSelectionIndex && pos <= *currentSelectionIndex) {
-		--*currentSelectionIndex;
-	}
-
-	auto optPos = pos_by_id(randomOrderPlaylist, id);
-	assert(optPos);
-	pos = *optPos;
-	randomOrderPlaylist.remove(pos);
-	if (currentRandomSelectionIndex && pos <= *currentRandomSelectionIndex) {
-		--*currentRandomSelectionIndex;
-	}
+	applyBatch({edit::Remove{pos}});
 }
 
 //------------------------------------------------------------------------------
 void Player::move(std::size_t from, std::size_t to)
+{
+	applyBatch({edit::Move{from, to}});
+}
+
+//------------------------------------------------------------------------------
+void Player::applyBatch(std::vector<PlaylistEdit>&& edits)
 {
 	std::lock_guard l(mutex);
-	displayedPlaylist.move(from, to);
 
-	if (currentSelectionIndex) {
-		if (*currentSelectionIndex == from) {
-			*currentSelectionIndex = to;
-		} else if (from < *currentSelectionIndex && *currentSelectionIndex <= to) {
-			--*currentSelectionIndex;
-		} else if (to <= *currentSelectionIndex && *currentSelectionIndex < from) {
-			++*currentSelectionIndex;
+	// Selections are followed by ID while editing, and converted back to positions once.
+	auto idAt = [](const Playlist& playlist, std::optional<std::size_t> pos) {
+		return pos ? std::optional(playlist.getTracks()[*pos].first) : std::nullopt;
+	};
+	auto nextSnapshot = *snapshot.load();
+	auto selectedId = idAt(displayedPlaylist, currentSelectionIndex);
+	auto randomSelectedId = idAt(randomOrderPlaylist, currentRandomSelectionIndex);
+	// Removing the selected track selects the previous one.
+	auto removeFrom = [&](Playlist& playlist, std::size_t pos, std::optional<std::size_t>& id) {
+		if (id == playlist.getTracks()[pos].first) {
+			id = pos == 0 ? std::nullopt : idAt(playlist, pos - 1);
 		}
+		playlist.remove(pos);
+	};
+
+	for (auto& edit : edits) {
+		std::visit(
+			Overloaded{
+				[&](edit::Append& e) {
+					auto ref = TrackStore::global().intern(std::move(e.track));
+					nextSnapshot = nextSnapshot.insert(nextSnapshot.size(), ref);
+					displayedPlaylist.push_back(ref);
+					indexPath(displayedPlaylist.getTracks().back().first, ref);
+					randomOrderPlaylist.push_back(std::move(ref));
+				},
+				[&](edit::Insert& e) {
+					auto ref = TrackStore::global().intern(std::move(e.track));
+					nextSnapshot = nextSnapshot.insert(e.pos, ref);
+					displayedPlaylist.insertAt(e.pos, ref);
+					const auto pos = std::min(e.pos, displayedPlaylist.getTracks().size() - 1);
+					indexPath(displayedPlaylist.getTracks()[pos].first, ref);
+					randomOrderPlaylist.push_back(std::move(ref));
+				},
+				[&](edit::InsertRange& e) {
+					nextSnapshot = nextSnapshot.insert(e.pos, e.tracks);
+					displayedPlaylist.insertRange(e.pos, e.tracks);
+					const auto pos =
+						std::min(e.pos, displayedPlaylist.getTracks().size() - e.tracks.size());
+					for (std::size_t i = 0; i != e.tracks.size(); ++i) {
+						indexPath(displayedPlaylist.getTracks()[pos + i].first, e.tracks[i]);
+					}
+					// New tracks are not drawn yet in random order.
+					randomOrderPlaylist.insertRange(randomOrderPlaylist.getTracks().size(), e.tracks);
+				},
+				[&](edit::Remove& e) {
+					if (displayedPlaylist.getTracks().size() <= e.pos) {
+						return;
+					}
+					nextSnapshot = nextSnapshot.erase(e.pos);
+					// Copied: the entry is removed below.
+					const auto [id, track] = displayedPlaylist.getTracks()[e.pos];
+					unindexPath(id, track);
+					removeFrom(displayedPlaylist, e.pos, selectedId);
+
+					const auto randomPos = randomOrderPlaylist.positionOf(id);
+					assert(randomPos);
+					removeFrom(randomOrderPlaylist, *randomPos, randomSelectedId);
+				},
+				[&](edit::Move& e) {
+					nextSnapshot = nextSnapshot.move(e.from, e.to);
+					displayedPlaylist.move(e.from, e.to);
+				}},
+			edit);
 	}
+
+	currentSelectionIndex = selectedId ? displayedPlaylist.positionOf(*selectedId) : std::nullopt;
+	currentRandomSelectionIndex =
+		randomSelectedId ? randomOrderPlaylist.positionOf(*randomSelectedId) : std::nullopt;
+	snapshot.store(std::make_shared<const PlaylistSnapshot>(std::move(nextSnapshot)));
 }
 //------------------------------------------------------------------------------
 void Player::removeDuplicate()
@@ -324,30 +425,196 @@ void Player::removeDuplicate()
 		id = randomOrderPlaylist.getTracks()[*currentRandomSelectionIndex].first;
 	}
 
-	displayedPlaylist.removeDuplicate();
+	displayedPlaylist.removeDuplicate(Execution::Parallel);
 	randomOrderPlaylist = displayedPlaylist; // ensure ID are still identical.
+	publishSnapshot();
+	reindexPaths();
 	if (id) {
-		currentSelectionIndex = pos_by_id(displayedPlaylist, *id);
+		currentSelectionIndex = displayedPlaylist.positionOf(*id);
 		if (randomModeActivated) {
-			randomOrderPlaylist.shuffle();
+			prepareRandomMode();
+		} else {
+			currentRandomSelectionIndex = randomOrderPlaylist.positionOf(*id);
 		}
-		currentRandomSelectionIndex = pos_by_id(randomOrderPlaylist, *id);
 	}
 }
 
 //------------------------------------------------------------------------------
-void Player::info_tracks(std::ostream& os)
+void Player::refreshTracks(std::span<const std::filesystem::path> paths)
 {
+	// Parse outside of the lock; nullptr for unreadable headers.
+	struct Update
+	{
+		InternedPath directory;
+		TrackRef track;
+	};
+	std::unordered_map<InternedPath, Update> updates;
+	for (const auto& path : paths) {
+		const auto normalized = normalizedPath(path);
+		auto header = tryOpenTrackHeader(path);
+		updates[normalized] = {normalized.parent_path(),
+		                       header ? TrackStore::global().intern(std::move(*header)) : nullptr};
+	}
+
 	std::lock_guard l(mutex);
-	displayedPlaylist.info(os);
+	auto nextSnapshot = *snapshot.load();
+	bool displayedChanged = false;
+	for (const auto& [path, update] : updates) {
+		const auto directory = trackIdsByDirectory.find(update.directory);
+		if (directory == trackIdsByDirectory.end()) {
+			continue;
+		}
+		const auto [first, last] = directory->second.equal_range(path);
+		for (auto it = first; it != last; ++it) {
+			const auto id = it->second;
+			const auto pos = displayedPlaylist.positionOf(id);
+			assert(pos);
+			const auto& track = displayedPlaylist.getTracks()[*pos].second;
+			TrackMetadataCache::global().invalidate(track->filename);
+			if (!update.track) {
+				unplayableTracks.insert(track->filename);
+				continue;
+			}
+			unplayableTracks.erase(track->filename);
+			auto header = *update.track;
+			header.filename = track->filename; // as written by the user
+			auto updated = TrackStore::global().intern(std::move(header));
+			if (updated == track) {
+				continue;
+			}
+			nextSnapshot = nextSnapshot.erase(*pos).insert(*pos, updated);
+			displayedChanged = true;
+			if (const auto randomPos = randomOrderPlaylist.positionOf(id)) {
+				randomOrderPlaylist.replace(*randomPos, updated);
+			}
+			displayedPlaylist.replace(*pos, std::move(updated));
+		}
+	}
+	if (displayedChanged) {
+		snapshot.store(std::make_shared<const PlaylistSnapshot>(std::move(nextSnapshot)));
+	}
 }
 
 //------------------------------------------------------------------------------
-void Player::info_track(std::ostream& os, std::size_t pos)
+void Player::markRemovedDirectories(std::span<const std::filesystem::path> directories)
 {
 	std::lock_guard l(mutex);
-	if (pos < displayedPlaylist.getTracks().size()) {
-		infoTrack(os, displayedPlaylist.getTracks()[pos].second);
+	for (const auto& path : directories) {
+		const auto directory = trackIdsByDirectory.find(normalizedPath(path));
+		if (directory == trackIdsByDirectory.end()) {
+			continue;
+		}
+		for (const auto& [filename, id] : directory->second) {
+			const auto pos = displayedPlaylist.positionOf(id);
+			assert(pos);
+			const auto& track = displayedPlaylist.getTracks()[*pos].second;
+			TrackMetadataCache::global().invalidate(track->filename);
+			unplayableTracks.insert(track->filename);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void Player::refreshAllTracks()
+{
+	std::vector<std::filesystem::path> paths;
+	{
+		std::lock_guard l(mutex);
+		for (const auto& [directory, ids] : trackIdsByDirectory) {
+			for (const auto& [filename, id] : ids) {
+				paths.push_back(filename);
+			}
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+	refreshTracks(paths);
+}
+
+//------------------------------------------------------------------------------
+bool Player::isPlayable(const TrackHeader& track) const
+{
+	std::lock_guard l(mutex);
+	return !unplayableTracks.contains(track.filename);
+}
+
+//------------------------------------------------------------------------------
+bool Player::watch(const std::filesystem::path& directory, bool recursive)
+{
+	std::lock_guard l(mutex);
+	if (!watcher) {
+		watcher = std::make_unique<LibraryWatcher>(
+			[this](LibraryChanges changes) {
+				if (changes.overflow) {
+					refreshAllTracks();
+					return;
+				}
+				markRemovedDirectories(changes.removedDirectories); // before files moved back
+				refreshTracks(changes.files);
+			});
+	}
+	return watcher->watch(directory, recursive);
+}
+
+//------------------------------------------------------------------------------
+void Player::indexPath(std::size_t id, const TrackRef& track)
+{
+	const auto path = normalizedPath(track->filename);
+	trackIdsByDirectory[path.parent_path()].emplace(path, id);
+}
+
+//------------------------------------------------------------------------------
+void Player::unindexPath(std::size_t id, const TrackRef& track)
+{
+	const auto path = normalizedPath(track->filename);
+	const auto directory = trackIdsByDirectory.find(path.parent_path());
+	if (directory == trackIdsByDirectory.end()) {
+		return;
+	}
+	auto& ids = directory->second;
+	const auto [first, last] = ids.equal_range(path);
+	const auto it =
+		std::find_if(first, last, [&](const auto& entry) { return entry.second == id; });
+	if (it != last) {
+		ids.erase(it);
+	}
+	if (ids.empty()) {
+		trackIdsByDirectory.erase(directory);
+	}
+}
+
+//------------------------------------------------------------------------------
+void Player::reindexPaths()
+{
+	trackIdsByDirectory.clear();
+	for (const auto& [id, track] : displayedPlaylist.getTracks()) {
+		indexPath(id, track);
+	}
+}
+
+//------------------------------------------------------------------------------
+void Player::publishSnapshot()
+{
+	std::vector<TrackRef> tracks;
+	tracks.reserve(displayedPlaylist.getTracks().size());
+	for (const auto& [id, track] : displayedPlaylist.getTracks()) {
+		tracks.push_back(track);
+	}
+	snapshot.store(std::make_shared<const PlaylistSnapshot>(tracks));
+}
+
+//------------------------------------------------------------------------------
+void Player::info_tracks(std::ostream& os)
+{
+	getSnapshot()->info(os);
+}
+
+//------------------------------------------------------------------------------
+void Player::info_track(std::ostream& os, std::size_t pos)
+{
+	const auto tracks = getSnapshot();
+	if (pos < tracks->size()) {
+		infoTrack(os, *(*tracks)[pos]);
 	}
 }
 
@@ -359,7 +626,7 @@ std::optional<std::size_t> Player::getSelectionIndex() const
 			return std::nullopt;
 		}
 		const auto& [id, track] = randomOrderPlaylist.getTracks()[*currentRandomSelectionIndex];
-		return pos_by_id(displayedPlaylist, id);
+		return displayedPlaylist.positionOf(id);
 	} else {
 		return currentSelectionIndex;
 	}
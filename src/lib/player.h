@@ -1,16 +1,50 @@
 #pragma once
 
 #include "imusicplayer.h"
+#include "librarywatcher.h"
 #include "playlist.h"
+#include "playlistsnapshot.h"
 
 #include <atomic>
 #include <mutex>
 #include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
 #include <vector>
 
 namespace iplayer
 {
 
+namespace edit
+{
+struct Append
+{
+	TrackHeader track;
+};
+struct Insert
+{
+	std::size_t pos;
+	TrackHeader track;
+};
+struct InsertRange
+{
+	std::size_t pos; // clamped, so past the end appends
+	std::vector<TrackRef> tracks;
+};
+struct Remove
+{
+	std::size_t pos;
+};
+struct Move
+{
+	std::size_t from;
+	std::size_t to;
+};
+} // namespace edit
+using PlaylistEdit = std::variant<edit::Append, edit::Insert, edit::InsertRange, edit::Remove, edit::Move>;
+
 /* Main class to simulate a music player */
 class Player
 {
@@ -39,25 +73,52 @@ public:
 	// playlist interface
 	void push_back(TrackHeader&&);
 	void insertAt(std::size_t pos, TrackHeader&& track);
+	// Bulk versions: headers are moved from, and interned before locking.
+	void append(std::span<TrackHeader>);
+	void insertRange(std::size_t pos, std::span<TrackHeader>);
 
 	void remove(std::size_t);
 	void move(std::size_t from, std::size_t to);
 
+	// Apply all edits, in order, under a single lock;
+	// selections are fixed up once at the end.
+	void applyBatch(std::vector<PlaylistEdit>&&);
+
 	void removeDuplicate();
 
+	// Re-read headers of changed files: their tracks are updated, or marked unplayable
+	// (and skipped by next/previous/select without opening them) if the header cannot be read.
+	void refreshTracks(std::span<const std::filesystem::path>);
+	// Mark tracks under removed directories (not their sub-directories) as unplayable.
+	void markRemovedDirectories(std::span<const std::filesystem::path>);
+	// Refresh every track, e.g. when file events were lost.
+	void refreshAllTracks();
+	bool isPlayable(const TrackHeader&) const;
+	// Refresh tracks automatically when files of `directory` change (see LibraryWatcher).
+	bool watch(const std::filesystem::path& directory, bool recursive = true);
+
+	// Readers below never lock: they work on the last published snapshot.
+	std::shared_ptr<const PlaylistSnapshot> getSnapshot() const { return snapshot.load(); }
+
 	void info_tracks(std::ostream&);
 	void info_track(std::ostream&, std::size_t);
 
-	std::size_t getTrackCount() const { return displayedPlaylist.getTracks().size(); }
-	const TrackHeader& getTrack(std::size_t n) const { return displayedPlaylist.getTracks().at(n).second; }
+	std::size_t getTrackCount() const { return getSnapshot()->size(); }
+	TrackRef getTrack(std::size_t n) const { return getSnapshot()->at(n); }
 
 private:
 	void previous(Playlist&, std::optional<std::size_t>&);
 	void next(Playlist&, std::optional<std::size_t>&);
 	void prepareRandomMode();
+	bool open(const TrackRef&);
+	void prefetchNext();
+	void publishSnapshot();
+	void indexPath(std::size_t id, const TrackRef&);
+	void unindexPath(std::size_t id, const TrackRef&);
+	void reindexPaths();
 
 private:
-	std::recursive_mutex mutex;
+	mutable std::recursive_mutex mutex;
 	std::function<void()> onMusicChanged;
 	std::shared_ptr<IMusicPlayer> musicPlayer;
 	std::optional<std::size_t> currentSelectionIndex;
@@ -65,8 +126,15 @@ private:
 	bool playing = false;
 	Playlist displayedPlaylist;
 	Playlist randomOrderPlaylist;
+	std::atomic<std::shared_ptr<const PlaylistSnapshot>> snapshot; // of displayedPlaylist
 	std::atomic<bool> repeatModeActivated = false;
 	std::atomic<bool> randomModeActivated = false;
+	std::unordered_set<InternedPath> unplayableTracks;
+	// Normalized directory -> normalized filename -> IDs of its tracks (same IDs in both
+	// playlists), to refresh tracks without scanning the playlist.
+	using TrackIds = std::unordered_multimap<InternedPath, std::size_t>;
+	std::unordered_map<InternedPath, TrackIds> trackIdsByDirectory;
+	std::unique_ptr<LibraryWatcher> watcher; // last, so stopped first
 };
 
 } // namespace iplayer
\ No newline at end of file
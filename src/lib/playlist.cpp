@@ -1,28 +1,151 @@
 #include "playlist.h"
 
 #include <algorithm>
+#include <iterator>
 #include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t parallelDedupeThreshold = 50'000;
+
+//------------------------------------------------------------------------------
+std::default_random_engine& rng()
+{
+	static thread_local std::default_random_engine rng{std::random_device()()};
+	return rng;
+}
+
+//------------------------------------------------------------------------------
+std::size_t threadCount()
+{
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+//------------------------------------------------------------------------------
+template <typename F>
+void runSharded(std::size_t shardCount, F f)
+{
+	if (shardCount == 1) {
+		f(std::size_t(0));
+		return;
+	}
+	std::vector<std::thread> threads;
+	threads.reserve(shardCount);
+	for (std::size_t shard = 0; shard != shardCount; ++shard) {
+		threads.emplace_back(f, shard);
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+} // namespace
 
 namespace iplayer
 {
+//------------------------------------------------------------------------------
+Playlist::Playlist(const Playlist& rhs) :
+	counter(rhs.counter),
+	tracks(rhs.tracks),
+	drawnCount(rhs.drawnCount)
+{
+	reindex();
+}
+
+//------------------------------------------------------------------------------
+Playlist& Playlist::operator=(const Playlist& rhs)
+{
+	Playlist tmp(rhs);
+	*this = std::move(tmp);
+	return *this;
+}
+
+//------------------------------------------------------------------------------
+void Playlist::reindex()
+{
+	iteratorsById.clear();
+	iteratorsById.reserve(tracks.size());
+	for (auto it = tracks.begin(); it != tracks.end(); ++it) {
+		iteratorsById.emplace(it->first, it);
+	}
+}
+
 //------------------------------------------------------------------------------
 void Playlist::push_back(TrackHeader&& track)
 {
-	tracks.emplace_back(counter++, std::move(track));
+	push_back(TrackStore::global().intern(std::move(track)));
+}
+
+//------------------------------------------------------------------------------
+void Playlist::push_back(TrackRef track)
+{
+	const auto id = counter++;
+	iteratorsById.emplace(id, tracks.emplace_back(id, std::move(track)));
 }
 
 //------------------------------------------------------------------------------
 void Playlist::insertAt(std::size_t pos, TrackHeader&& track)
 {
+	insertAt(pos, TrackStore::global().intern(std::move(track)));
+}
+
+//------------------------------------------------------------------------------
+void Playlist::insertAt(std::size_t pos, TrackRef track)
+{
+	pos = std::clamp(pos, std::size_t(0), tracks.size());
+	const auto id = counter++;
+	iteratorsById.emplace(id, tracks.emplace(pos, id, std::move(track)));
+	if (drawnCount && pos < *drawnCount) {
+		++*drawnCount;
+	}
+}
+
+//------------------------------------------------------------------------------
+void Playlist::append(std::span<TrackHeader> newTracks)
+{
+	std::vector<TrackRef> refs;
+	refs.reserve(newTracks.size());
+	for (auto& track : newTracks) {
+		refs.push_back(TrackStore::global().intern(std::move(track)));
+	}
+	insertRange(tracks.size(), refs);
+}
+
+//------------------------------------------------------------------------------
+void Playlist::insertRange(std::size_t pos, std::span<const TrackRef> newTracks)
+{
+	if (newTracks.empty()) {
+		return;
+	}
 	pos = std::clamp(pos, std::size_t(0), tracks.size());
-	tracks.emplace(tracks.begin() + pos, counter++, std::move(track));
+	std::vector<std::pair<std::size_t, TrackRef>> entries;
+	entries.reserve(newTracks.size());
+	for (const auto& track : newTracks) {
+		entries.emplace_back(counter++, track);
+	}
+	auto it = tracks.insert(
+		pos, std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+	iteratorsById.reserve(tracks.size());
+	for (std::size_t i = 0; i != newTracks.size(); ++i, ++it) {
+		iteratorsById.emplace(it->first, it);
+	}
+	if (drawnCount && pos < *drawnCount) {
+		*drawnCount += newTracks.size();
+	}
 }
 
 //------------------------------------------------------------------------------
 void Playlist::remove(std::size_t pos)
 {
 	if (pos < tracks.size()) {
-		tracks.erase(tracks.begin() + pos);
+		iteratorsById.erase(tracks[pos].first);
+		tracks.erase(pos);
+		if (drawnCount && pos < *drawnCount) {
+			--*drawnCount;
+		}
 	}
 }
 
@@ -32,32 +155,115 @@ void Playlist::move(std::size_t from, std::size_t to)
 	if (tracks.size() <= from || tracks.size() <= to || from == to) {
 		return;
 	}
-	if (from < to) {
-		std::rotate(tracks.begin() + from, tracks.begin() + from + 1, tracks.begin() + to + 1);
-	} else {
-		std::rotate(tracks.begin() + to, tracks.begin() + from, tracks.begin() + from + 1);
+	tracks.move(from, to);
+}
+
+//------------------------------------------------------------------------------
+void Playlist::replace(std::size_t pos, TrackRef track)
+{
+	if (tracks.size() <= pos) {
+		return;
 	}
+	tracks[pos].second = std::move(track);
 }
 
 //------------------------------------------------------------------------------
-void Playlist::removeDuplicate()
+void Playlist::removeDuplicate(Execution execution)
 {
 	// if order is not kept, sort+unique, but for stable remove duplicate
-	auto dest = tracks.begin();
-	for (const auto& t : tracks) {
-		if (std::find_if(tracks.begin(), dest, [&](const auto& p) { return p.second.filename == t.second.filename; }) == dest) {
-			*dest = t;
+	auto v = tracks.extract();
+	const bool parallel =
+		execution == Execution::Parallel && parallelDedupeThreshold <= v.size();
+	const std::size_t shardCount = parallel ? threadCount() : 1;
+	std::vector<std::size_t> hashes(v.size());
+
+	runSharded(shardCount, [&](std::size_t shard) {
+		for (std::size_t i = shard; i < v.size(); i += shardCount) {
+			hashes[i] = v[i].second->filename.hash();
+		}
+	});
+
+	// Equal filenames have equal hashes, so they end in the same shard,
+	// and each shard sees its tracks in order: first occurrence wins.
+	std::vector<char> kept(v.size(), false);
+	runSharded(shardCount, [&](std::size_t shard) {
+		auto hash = [&](std::size_t i) { return hashes[i]; };
+		auto equal = [&](std::size_t lhs, std::size_t rhs) {
+			return v[lhs].second->filename == v[rhs].second->filename;
+		};
+		std::unordered_set<std::size_t, decltype(hash), decltype(equal)> seen(
+			v.size() / shardCount, hash, equal);
+		for (std::size_t i = 0; i != v.size(); ++i) {
+			if (hashes[i] % shardCount == shard) {
+				kept[i] = seen.insert(i).second;
+			}
+		}
+	});
+
+	auto dest = v.begin();
+	for (std::size_t i = 0; i != v.size(); ++i) {
+		if (kept[i]) {
+			if (&*dest != &v[i]) {
+				*dest = std::move(v[i]);
+			}
 			++dest;
 		}
 	}
-	tracks.erase(dest, tracks.end());
+	tracks.assign(std::make_move_iterator(v.begin()), std::make_move_iterator(dest));
+	reindex();
+	drawnCount.reset();
+}
+
+//------------------------------------------------------------------------------
+std::optional<std::size_t> Playlist::positionOf(std::size_t id) const
+{
+	auto it = iteratorsById.find(id);
+
+	if (it != iteratorsById.end()) {
+		return tracks.indexOf(it->second);
+	} else {
+		return std::nullopt;
+	}
 }
 
 //------------------------------------------------------------------------------
 void Playlist::shuffle()
 {
-	static thread_local std::default_random_engine rng{std::random_device()()};
-	std::shuffle(tracks.begin(), tracks.end(), rng);
+	auto v = tracks.extract();
+	std::shuffle(v.begin(), v.end(), rng());
+	tracks.assign(std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
+	reindex();
+	drawnCount.reset();
+}
+
+//------------------------------------------------------------------------------
+void Playlist::shuffleLazily(std::size_t drawnPrefix)
+{
+	drawnCount = std::min(drawnPrefix, tracks.size());
+}
+
+//------------------------------------------------------------------------------
+void Playlist::draw(std::size_t pos)
+{
+	if (!drawnCount) {
+		return;
+	}
+	for (; *drawnCount <= pos && *drawnCount < tracks.size(); ++*drawnCount) {
+		const auto i = *drawnCount;
+		swap(i, std::uniform_int_distribution<std::size_t>{i, tracks.size() - 1}(rng()));
+	}
+}
+
+//------------------------------------------------------------------------------
+void Playlist::swap(std::size_t lhs, std::size_t rhs)
+{
+	if (lhs == rhs) {
+		return;
+	}
+	auto& l = tracks[lhs];
+	auto& r = tracks[rhs];
+	std::swap(l, r);
+	std::swap(iteratorsById[l.first], iteratorsById[r.first]);
 }
 
 //------------------------------------------------------------------------------
@@ -65,7 +271,7 @@ void Playlist::info(std::ostream& os) const
 {
 	os << "Nb tracks: " << tracks.size() << "\n";
 	for (const auto& [id, track] : tracks) {
-		os << "- " << track.title << "\n";
+		os << "- " << track->title << "\n";
 	}
 }
 
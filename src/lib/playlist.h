@@ -1,31 +1,71 @@
 #pragma once
 
+#include "orderstatistictree.h"
 #include "trackheader.h"
+#include "trackstore.h"
 
-#include <vector>
+#include <optional>
+#include <span>
+#include <unordered_map>
 
 namespace iplayer
 {
 
+enum class Execution
+{
+	Sequential,
+	Parallel // only worth it for very large playlists
+};
+
 class Playlist
 {
 public:
+	using Tracks = OrderStatisticTree<std::pair<std::size_t, TrackRef>>;
+
+	Playlist() = default;
+	Playlist(const Playlist&);
+	Playlist(Playlist&&) = default;
+	Playlist& operator=(const Playlist&);
+	Playlist& operator=(Playlist&&) = default;
+
 	void push_back(TrackHeader&&);
+	void push_back(TrackRef);
 	void insertAt(std::size_t pos, TrackHeader&& track);
+	void insertAt(std::size_t pos, TrackRef track);
+	// Bulk versions, in O(k + log n); headers are moved from.
+	void append(std::span<TrackHeader>);
+	void insertRange(std::size_t pos, std::span<const TrackRef>);
 
 	void remove(std::size_t);
 	void move(std::size_t from, std::size_t to);
+	// Replace the header of track at `pos`, keeping its ID.
+	void replace(std::size_t pos, TrackRef);
 
-	void removeDuplicate();
+	// Stable: keep first occurrence of each filename.
+	void removeDuplicate(Execution = Execution::Sequential);
 
-	const std::vector<std::pair<std::size_t, TrackHeader>>& getTracks() const { return tracks; }
+	const Tracks& getTracks() const { return tracks; }
+	// Current position of track with unique ID `id`, in O(log n).
+	std::optional<std::size_t> positionOf(std::size_t id) const;
 
 	void shuffle();
+	// Incremental Fisher-Yates: positions are only drawn on demand by draw(),
+	// the first `drawnPrefix` positions are kept as already drawn.
+	void shuffleLazily(std::size_t drawnPrefix = 0);
+	// Ensure positions [0, pos] are drawn: O(1) per new position (amortized O(log n)).
+	// No-op when not lazily shuffled.
+	void draw(std::size_t pos);
 
 	void info(std::ostream&) const;
 
+private:
+	void reindex();
+	void swap(std::size_t, std::size_t);
+
 private:
 	std::size_t counter = 0; // Used for unique ID
-	std::vector<std::pair<std::size_t, TrackHeader>> tracks;
+	Tracks tracks;
+	std::unordered_map<std::size_t, Tracks::const_iterator> iteratorsById;
+	std::optional<std::size_t> drawnCount; // set when lazily shuffled
 };
 } // namespace iplayer
@@ -0,0 +1,248 @@
+#include "playlistsnapshot.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+constexpr std::size_t chunkCapacity = 512; // chunks are split beyond
+
+//------------------------------------------------------------------------------
+template <typename NodePtr>
+int heightOf(const NodePtr& node)
+{
+	return node ? node->height : -1;
+}
+
+//------------------------------------------------------------------------------
+template <typename NodePtr>
+const NodePtr& firstLeaf(const NodePtr& node)
+{
+	return node->height == 0 ? node : firstLeaf(node->left);
+}
+
+//------------------------------------------------------------------------------
+template <typename NodePtr>
+const NodePtr& lastLeaf(const NodePtr& node)
+{
+	return node->height == 0 ? node : lastLeaf(node->right);
+}
+
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+PlaylistSnapshot::PlaylistSnapshot(const std::vector<TrackRef>& tracks) : root(build(tracks))
+{}
+
+//------------------------------------------------------------------------------
+const TrackRef& PlaylistSnapshot::operator[](std::size_t pos) const
+{
+	const Node* node = root.get();
+	while (node->height != 0) {
+		if (pos < node->left->size) {
+			node = node->left.get();
+		} else {
+			pos -= node->left->size;
+			node = node->right.get();
+		}
+	}
+	return node->chunk[pos];
+}
+
+//------------------------------------------------------------------------------
+const TrackRef& PlaylistSnapshot::at(std::size_t pos) const
+{
+	if (size() <= pos) {
+		throw std::out_of_range("PlaylistSnapshot::at");
+	}
+	return (*this)[pos];
+}
+
+//------------------------------------------------------------------------------
+PlaylistSnapshot PlaylistSnapshot::insert(std::size_t pos, TrackRef track) const
+{
+	return insert(pos, std::span<const TrackRef>(&track, 1));
+}
+
+//------------------------------------------------------------------------------
+PlaylistSnapshot PlaylistSnapshot::insert(std::size_t pos, std::span<const TrackRef> tracks) const
+{
+	if (tracks.empty()) {
+		return *this;
+	}
+	auto [left, right] = split(root, std::clamp(pos, std::size_t(0), size()));
+	return PlaylistSnapshot(link(link(std::move(left), build(tracks)), std::move(right)));
+}
+
+//------------------------------------------------------------------------------
+PlaylistSnapshot PlaylistSnapshot::erase(std::size_t pos) const
+{
+	if (size() <= pos) {
+		return *this;
+	}
+	auto [left, right] = split(root, pos);
+	return PlaylistSnapshot(link(std::move(left), split(right, 1).second));
+}
+
+//------------------------------------------------------------------------------
+PlaylistSnapshot PlaylistSnapshot::move(std::size_t from, std::size_t to) const
+{
+	if (size() <= from || size() <= to || from == to) {
+		return *this;
+	}
+	return erase(from).insert(to, (*this)[from]);
+}
+
+//------------------------------------------------------------------------------
+void PlaylistSnapshot::info(std::ostream& os) const
+{
+	os << "Nb tracks: " << size() << "\n";
+	forEach([&](const TrackRef& track) { os << "- " << track->title << "\n"; });
+}
+
+//------------------------------------------------------------------------------
+std::size_t PlaylistSnapshot::getChunkCount() const
+{
+	std::size_t res = 0;
+	auto count = [&](auto& self, const Node* node) -> void {
+		if (node) {
+			res += node->height == 0;
+			self(self, node->left.get());
+			self(self, node->right.get());
+		}
+	};
+	count(count, root.get());
+	return res;
+}
+
+//------------------------------------------------------------------------------
+auto PlaylistSnapshot::makeLeaf(Chunk&& chunk) -> NodePtr
+{
+	const auto size = chunk.size();
+	return std::make_shared<const Node>(Node{nullptr, nullptr, std::move(chunk), size, 0});
+}
+
+//------------------------------------------------------------------------------
+auto PlaylistSnapshot::makeNode(NodePtr left, NodePtr right) -> NodePtr
+{
+	const auto size = left->size + right->size;
+	const auto height = std::max(left->height, right->height) + 1;
+	return std::make_shared<const Node>(Node{std::move(left), std::move(right), {}, size, height});
+}
+
+//------------------------------------------------------------------------------
+// Node of `left` and `right`, whose heights differ by at most 2, with an AVL rotation if needed.
+auto PlaylistSnapshot::balance(NodePtr left, NodePtr right) -> NodePtr
+{
+	if (heightOf(left) > heightOf(right) + 1) {
+		if (heightOf(left->left) >= heightOf(left->right)) {
+			return makeNode(left->left, makeNode(left->right, std::move(right)));
+		}
+		return makeNode(makeNode(left->left, left->right->left),
+		                makeNode(left->right->right, std::move(right)));
+	}
+	if (heightOf(right) > heightOf(left) + 1) {
+		if (heightOf(right->right) >= heightOf(right->left)) {
+			return makeNode(makeNode(std::move(left), right->left), right->right);
+		}
+		return makeNode(makeNode(std::move(left), right->left->left),
+		                makeNode(right->left->right, right->right));
+	}
+	return makeNode(std::move(left), std::move(right));
+}
+
+//------------------------------------------------------------------------------
+// Balanced tree of evenly split chunks, so no tiny chunk is left behind.
+auto PlaylistSnapshot::build(std::span<const TrackRef> tracks) -> NodePtr
+{
+	if (tracks.empty()) {
+		return nullptr;
+	}
+	const std::size_t count = (tracks.size() + chunkCapacity - 1) / chunkCapacity;
+	if (count == 1) {
+		return makeLeaf(Chunk(tracks.begin(), tracks.end()));
+	}
+	// Split on a chunk boundary, so both halves have the same chunk sizes as a whole build.
+	const auto middle = count / 2 * tracks.size() / count;
+	return makeNode(build(tracks.first(middle)), build(tracks.subspan(middle)));
+}
+
+//------------------------------------------------------------------------------
+// AVL join: O(height difference).
+auto PlaylistSnapshot::concat(NodePtr left, NodePtr right) -> NodePtr
+{
+	if (!left) {
+		return right;
+	}
+	if (!right) {
+		return left;
+	}
+	if (left->height > right->height + 1) {
+		return balance(left->left, concat(left->right, std::move(right)));
+	}
+	if (right->height > left->height + 1) {
+		return balance(concat(std::move(left), right->left), right->right);
+	}
+	return makeNode(std::move(left), std::move(right));
+}
+
+//------------------------------------------------------------------------------
+// concat(), keeping chunks around the junction at least a quarter full: the chunks on both sides
+// are merged when they fit in one, or evenly redistributed when one of them is underfull.
+auto PlaylistSnapshot::link(NodePtr left, NodePtr right) -> NodePtr
+{
+	if (!left || !right) {
+		return concat(std::move(left), std::move(right));
+	}
+	constexpr std::size_t minSize = chunkCapacity / 4;
+	const auto& last = lastLeaf(left);
+	const auto& first = firstLeaf(right);
+	if (chunkCapacity < last->size + first->size && minSize <= std::min(last->size, first->size)) {
+		return concat(std::move(left), std::move(right));
+	}
+	Chunk tracks;
+	tracks.reserve(last->size + first->size + chunkCapacity);
+	tracks.insert(tracks.end(), last->chunk.begin(), last->chunk.end());
+	tracks.insert(tracks.end(), first->chunk.begin(), first->chunk.end());
+	left = split(left, left->size - last->size).first;
+	right = split(right, first->size).second;
+	// Still underfull: absorb a neighbour chunk too.
+	if (tracks.size() < minSize && right) {
+		const auto& next = firstLeaf(right);
+		tracks.insert(tracks.end(), next->chunk.begin(), next->chunk.end());
+		right = split(right, next->size).second;
+	} else if (tracks.size() < minSize && left) {
+		const auto& previous = lastLeaf(left);
+		tracks.insert(tracks.begin(), previous->chunk.begin(), previous->chunk.end());
+		left = split(left, left->size - previous->size).first;
+	}
+	return concat(concat(std::move(left), build(tracks)), std::move(right));
+}
+
+//------------------------------------------------------------------------------
+// Tracks [0, pos) and [pos, size).
+auto PlaylistSnapshot::split(const NodePtr& node, std::size_t pos) -> std::pair<NodePtr, NodePtr>
+{
+	if (!node || pos == 0) {
+		return {nullptr, node};
+	}
+	if (node->size <= pos) {
+		return {node, nullptr};
+	}
+	if (node->height == 0) {
+		const auto middle = node->chunk.begin() + static_cast<std::ptrdiff_t>(pos);
+		return {makeLeaf(Chunk(node->chunk.begin(), middle)),
+		        makeLeaf(Chunk(middle, node->chunk.end()))};
+	}
+	if (pos <= node->left->size) {
+		auto [first, second] = split(node->left, pos);
+		return {std::move(first), concat(std::move(second), node->right)};
+	}
+	auto [first, second] = split(node->right, pos - node->left->size);
+	return {concat(node->left, std::move(first)), std::move(second)};
+}
+
+} // namespace iplayer
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "trackstore.h"
+
+#include <iostream>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace iplayer
+{
+
+/* Immutable version of a playlist order, safe to read from any thread.
+   Tracks are stored in bounded chunks, leaves of a persistent balanced (AVL) tree shared
+   between versions: an edit returns a new version which copies O(log n) nodes and the one or two
+   chunks it touches. Adjacent chunks which would fit in one are merged, so erasing does not leave
+   tiny chunks behind. */
+class PlaylistSnapshot
+{
+public:
+	PlaylistSnapshot() = default;
+	explicit PlaylistSnapshot(const std::vector<TrackRef>&);
+
+	std::size_t size() const { return root ? root->size : 0; }
+	bool empty() const { return size() == 0; }
+	const TrackRef& operator[](std::size_t) const;
+	const TrackRef& at(std::size_t) const;
+
+	template <typename F>
+	void forEach(F f) const
+	{
+		forEach(root.get(), f);
+	}
+
+	// Same semantic as Playlist's counterparts.
+	PlaylistSnapshot insert(std::size_t pos, TrackRef) const;
+	PlaylistSnapshot insert(std::size_t pos, std::span<const TrackRef>) const;
+	PlaylistSnapshot erase(std::size_t pos) const;
+	PlaylistSnapshot move(std::size_t from, std::size_t to) const;
+
+	void info(std::ostream&) const;
+
+	std::size_t getChunkCount() const; // O(n / chunk size)
+
+private:
+	using Chunk = std::vector<TrackRef>;
+	struct Node;
+	using NodePtr = std::shared_ptr<const Node>;
+
+	struct Node
+	{
+		NodePtr left; // null for leaves
+		NodePtr right;
+		Chunk chunk; // leaves only, never empty
+		std::size_t size;
+		int height; // 0 for leaves
+	};
+
+	explicit PlaylistSnapshot(NodePtr root) : root(std::move(root)) {}
+
+	template <typename F>
+	static void forEach(const Node* node, F& f)
+	{
+		if (!node) {
+			return;
+		}
+		if (node->height == 0) {
+			for (const auto& track : node->chunk) {
+				f(track);
+			}
+			return;
+		}
+		forEach(node->left.get(), f);
+		forEach(node->right.get(), f);
+	}
+
+	static NodePtr makeLeaf(Chunk&&);
+	static NodePtr makeNode(NodePtr left, NodePtr right);
+	static NodePtr balance(NodePtr left, NodePtr right);
+	static NodePtr build(std::span<const TrackRef>);
+	static NodePtr concat(NodePtr left, NodePtr right);
+	static NodePtr link(NodePtr left, NodePtr right);
+	static std::pair<NodePtr, NodePtr> split(const NodePtr&, std::size_t pos);
+
+private:
+	NodePtr root;
+};
+
+} // namespace iplayer
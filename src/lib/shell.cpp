@@ -1,5 +1,7 @@
 #include "shell.h"
 
+#include "libraryimporter.h"
+
 #include <functional>
 #include <map>
 #include <sstream>
@@ -41,6 +43,37 @@ void add_track(iplayer::Player& player, std::ostream& os, std::istream& is)
 	}
 }
 //------------------------------------------------------------------------------
+void add_dir(iplayer::Player& player, std::ostream& os, std::istream& is)
+{
+	std::string directory;
+	if (!std::getline(is >> std::ws, directory)) {
+		os << "Invalid argument\n";
+		return;
+	}
+	try {
+		os << "Adding directory " << directory << "\n";
+		const auto summary = iplayer::importDirectory(player, directory);
+		os << "Added " << summary.importedCount << " tracks\n";
+		if (!player.watch(directory)) {
+			os << "Directory is not watched for changes\n";
+		}
+		if (!summary.invalidFiles.empty()) {
+			os << "Ignored " << summary.invalidFiles.size() << " invalid files:\n";
+			for (const auto& file : summary.invalidFiles) {
+				os << "- " << file.path.string() << ": " << iplayer::toString(file.error.code);
+				if (file.error.code != iplayer::TrackHeaderError::Code::NotFound) {
+					os << " at offset " << file.error.offset;
+				}
+				os << "\n";
+			}
+		}
+	}
+	catch (const std::exception& ex) {
+		os << ex.what() << "\n";
+		os << "Current path is " << std::filesystem::current_path() << "\n";
+	}
+}
+//------------------------------------------------------------------------------
 void move_track(iplayer::Player& player, std::ostream& os, std::istream& is)
 {
 	std::size_t from;
@@ -91,7 +124,7 @@ void play(iplayer::Player& player, std::ostream& os, std::istream&)
 	player.play();
 	auto index = player.getSelectionIndex();
 	if (index) {
-		os << "Playing: " << player.getTrack(*index).title << "\n";
+		os << "Playing: " << player.getTrack(*index)->title << "\n";
 	} else {
 		os << "Nothing to play\n";
 	}
@@ -115,7 +148,7 @@ void next(iplayer::Player& player, std::ostream&os, std::istream&)
 	player.next();
 	auto index = player.getSelectionIndex();
 	if (index) {
-		os << "selection: " << player.getTrack(*index).title << "\n";
+		os << "selection: " << player.getTrack(*index)->title << "\n";
 	} else {
 		os << "No selection\n";
 	}
@@ -127,7 +160,7 @@ void previous(iplayer::Player& player, std::ostream&os, std::istream&)
 	player.previous();
 	auto index = player.getSelectionIndex();
 	if (index) {
-		os << "selection: " << player.getTrack(*index).title << "\n";
+		os << "selection: " << player.getTrack(*index)->title << "\n";
 	} else {
 		os << "No selection\n";
 	}
@@ -141,7 +174,7 @@ void select(iplayer::Player& player, std::ostream& os, std::istream& is)
 		player.select(pos);
 		auto index = player.getSelectionIndex();
 		if (index) {
-			os << "selection: " << player.getTrack(*index).title << "\n";
+			os << "selection: " << player.getTrack(*index)->title << "\n";
 		} else {
 			os << "No selection\n";
 		}
@@ -184,6 +217,7 @@ const static std::map<std::string, Command> commands{
 	{"help", {showHelp}},
 	{"cd", {cd, " $directory"}},
 	{"add_track", {add_track, " $file ($pos)"}},
+	{"add_dir", {add_dir, " $directory"}},
 	{"move_track", {move_track, " $from $to"}},
 	{"remove_track", {remove_track, " $pos"}},
 	{"info_track", {info_track, " $pos"}},
@@ -217,14 +251,22 @@ namespace iplayer
 
 //------------------------------------------------------------------------------
 Shell::Shell(std::shared_ptr<Player> player, std::istream& is, std::ostream& os) :
+	Shell(std::move(player), is, os, os)
+{}
+
+//------------------------------------------------------------------------------
+Shell::Shell(std::shared_ptr<Player> player,
+             std::istream& is,
+             std::ostream& os,
+             std::ostream& eventOs) :
 	player(std::move(player)),
 	is(is),
 	os(os)
 {
-	this->player->setOnMusicChanged([this]() {
+	this->player->setOnMusicChanged([this, &eventOs]() {
 		if (auto index = this->player->getSelectionIndex()) {
-			const auto& track = this->player->getTrack(*index);
-			this->os << "Switcing to: " << track.title << "\n";
+			const auto track = this->player->getTrack(*index);
+			eventOs << "Switcing to: " << track->title << "\n";
 		}
 	});
 }
@@ -11,6 +11,8 @@ namespace iplayer
 	{
 	public:
 		Shell(std::shared_ptr<Player>, std::istream&, std::ostream&);
+		// `eventOs` is written from the thread notifying music changes.
+		Shell(std::shared_ptr<Player>, std::istream&, std::ostream&, std::ostream& eventOs);
 		void run();
 
 	private:
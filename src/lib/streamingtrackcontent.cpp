@@ -0,0 +1,187 @@
+#include "streamingtrackcontent.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+constexpr std::size_t linesByTurn = 16; // read for a content before switching to the next one
+} // namespace
+
+namespace iplayer
+{
+
+/* Thread reading the streaming contents which need it, in turn. */
+class StreamingTrackContent::Reader
+{
+public:
+	static Reader& global()
+	{
+		static Reader reader;
+		return reader;
+	}
+
+	~Reader()
+	{
+		{
+			std::lock_guard l(mutex);
+			stop = true;
+		}
+		cv.notify_all();
+		thread.join();
+	}
+
+	void schedule(StreamingTrackContent& content)
+	{
+		{
+			std::lock_guard l(mutex);
+			if (content.queued) {
+				return;
+			}
+			content.queued = true;
+			queue.push_back(&content);
+		}
+		cv.notify_all();
+	}
+
+	// Once returned, `content` is not read anymore.
+	void remove(StreamingTrackContent& content)
+	{
+		std::unique_lock l(mutex);
+		if (content.queued) {
+			std::erase(queue, &content);
+			content.queued = false;
+		}
+		cv.wait(l, [&]() { return active != &content; });
+	}
+
+private:
+	Reader() : thread([this]() { run(); }) {}
+
+	void run()
+	{
+		std::unique_lock l(mutex);
+		while (true) {
+			cv.wait(l, [this]() { return stop || !queue.empty(); });
+			if (stop) {
+				return;
+			}
+			active = queue.front();
+			queue.pop_front();
+			active->queued = false;
+			l.unlock();
+			const bool more = active->readSome();
+			l.lock();
+			if (more && !active->queued) {
+				active->queued = true;
+				queue.push_back(active);
+			}
+			active = nullptr;
+			cv.notify_all();
+		}
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<StreamingTrackContent*> queue;
+	StreamingTrackContent* active = nullptr; // being read
+	bool stop = false;
+	std::thread thread;
+};
+
+//------------------------------------------------------------------------------
+StreamingTrackContent::StreamingTrackContent(std::ifstream&& file, const StreamingOptions& options) :
+	options{std::max<std::size_t>(1, options.readAhead),
+	        std::max<std::size_t>(1, options.checkpointInterval)},
+	file(std::move(file))
+{
+	checkpoints.push_back(this->file.tellg());
+	Reader::global().schedule(*this);
+}
+
+//------------------------------------------------------------------------------
+StreamingTrackContent::~StreamingTrackContent()
+{
+	Reader::global().remove(*this);
+}
+
+//------------------------------------------------------------------------------
+std::optional<std::string_view> StreamingTrackContent::getLine(std::size_t n)
+{
+	std::unique_lock l(mutex);
+	requested = n;
+	Reader::global().schedule(*this);
+	cv.wait(l, [&]() {
+		return (windowStart <= n && n < windowStart + window.size()) || (lineCount && *lineCount <= n);
+	});
+	if (lineCount && *lineCount <= n) {
+		return std::nullopt;
+	}
+	current = window[n - windowStart];
+	return current;
+}
+
+//------------------------------------------------------------------------------
+std::size_t StreamingTrackContent::getCheckpointCount()
+{
+	std::lock_guard l(mutex);
+	return checkpoints.size();
+}
+
+//------------------------------------------------------------------------------
+bool StreamingTrackContent::readSome()
+{
+	const auto interval = options.checkpointInterval;
+	std::unique_lock l(mutex);
+
+	for (std::size_t i = 0; i != linesByTurn; ++i) {
+		const auto next = windowStart + window.size(); // line at the file position
+		const auto checkpoint = requested / interval;
+		if (requested < windowStart || (checkpoint < checkpoints.size() && next < checkpoint * interval)) {
+			seekToCheckpointOf(requested);
+			continue;
+		}
+		while (!window.empty() && windowStart < requested) {
+			window.pop_front();
+			++windowStart;
+		}
+		if (options.readAhead < window.size() || (lineCount && *lineCount <= next)) {
+			return false; // until getLine
+		}
+
+		const bool isCheckpoint = next % interval == 0 && next / interval == checkpoints.size();
+		l.unlock(); // `requested` might change, but only this thread changes the window
+		const std::streamoff offset = isCheckpoint ? std::streamoff(file.tellg()) : 0;
+		std::string line;
+		const bool ok = static_cast<bool>(std::getline(file, line));
+		l.lock();
+
+		if (!ok) {
+			lineCount = next;
+		} else {
+			if (isCheckpoint) {
+				checkpoints.push_back(offset);
+			}
+			if (window.empty() && windowStart < requested) {
+				++windowStart; // skipped while seeking forward
+			} else {
+				window.push_back(std::move(line));
+			}
+		}
+		cv.notify_all();
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void StreamingTrackContent::seekToCheckpointOf(std::size_t line)
+{
+	const auto checkpoint = std::min(line / options.checkpointInterval, checkpoints.size() - 1);
+	window.clear();
+	windowStart = checkpoint * options.checkpointInterval;
+	file.clear();
+	file.seekg(checkpoints[checkpoint]);
+}
+
+} // namespace iplayer
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "trackcontent.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace iplayer
+{
+
+struct StreamingOptions
+{
+	std::size_t readAhead = 64; // lines kept in memory from the current one
+	std::size_t checkpointInterval = 256; // lines between two indexed file offsets
+};
+
+/* Text track content read in the background,
+   only `readAhead` lines ahead of the last accessed line.
+   Offsets of every `checkpointInterval`-th line are recorded while reading, so that a seek
+   re-reads at most `checkpointInterval` lines (forward seeks past the read part read through).
+   All contents share a single reading thread, which reads a few lines of each in turn. */
+class StreamingTrackContent : public TrackContent
+{
+public:
+	// `file` is positioned at the first line of the content.
+	explicit StreamingTrackContent(std::ifstream&& file, const StreamingOptions& = {});
+	~StreamingTrackContent();
+
+	StreamingTrackContent(const StreamingTrackContent&) = delete;
+	StreamingTrackContent& operator=(const StreamingTrackContent&) = delete;
+
+	// Wait for the line to be read if needed.
+	std::optional<std::string_view> getLine(std::size_t) override;
+
+	std::size_t getCheckpointCount();
+
+private:
+	class Reader;
+
+	bool readSome(); // on the reading thread; false when there is nothing left to read for now
+	void seekToCheckpointOf(std::size_t line); // with lock
+
+private:
+	const StreamingOptions options;
+	std::ifstream file; // used by the reading thread only, after construction
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<std::string> window; // lines [windowStart, windowStart + window.size())
+	std::size_t windowStart = 0;
+	std::size_t requested = 0; // last accessed line
+	std::optional<std::size_t> lineCount; // known once the end is reached
+	std::vector<std::streamoff> checkpoints; // of lines 0, checkpointInterval, ...
+	std::string current; // returned by getLine
+	bool queued = false; // in the Reader queue, under its lock
+};
+
+} // namespace iplayer
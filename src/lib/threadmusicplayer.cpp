@@ -1,6 +1,7 @@
 #include "threadmusicplayer.h"
 
-#include <fstream>
+#include <algorithm>
+#include <utility>
 
 using namespace std::literals;
 
@@ -8,79 +9,133 @@ namespace iplayer
 {
 
 //------------------------------------------------------------------------------
-ThreadMusicPlayer::ThreadMusicPlayer(std::ostream& os) : os(os)
+ThreadMusicPlayer::ThreadMusicPlayer(std::ostream& os,
+                                     TrackLoading loading,
+                                     std::chrono::nanoseconds period) :
+	os(os),
+	loading(loading),
+	linePeriod(std::max(period, std::chrono::nanoseconds(1)))
 {
 	thread = std::thread([this]() {
-		while (true) {
-			for (std::size_t i = 0; i != 5; ++i) {
-				if (stop) {
-					return;
-				}
-				std::this_thread::sleep_for(200ms);
-			}
+		std::unique_lock l{mutex};
+		// Line n is output when the position reaches (n + 1) periods.
+		std::chrono::nanoseconds nextTick{};
+		std::optional<std::uint32_t> clockVersion;
+
+		while (!stop) {
 			if (inPause) {
+				stateChanged.wait(l, [this]() { return stop || !inPause; });
+				continue;
+			}
+			if (clockVersion != clock.getVersion()) { // seeked, paused...
+				clockVersion = clock.getVersion();
+				nextTick = (clock.getPosition() / linePeriod + 1) * linePeriod;
+			}
+			// Deadlines come from the clock: late wake-ups do not accumulate.
+			if (stateChanged.wait_until(l, clock.timeAt(nextTick), [&]() {
+				    return stop || inPause || clockVersion != clock.getVersion();
+			    })) {
 				continue;
 			}
-			std::lock_guard l{mutex};
-			if (elapsedTime.count() >= content.size()) {
-				elapsedTime = 0s;
+			// getLine may wait for the disk: not under `mutex`, which would block the controls.
+			const auto current = content; // kept alive even if openMusic replaces it
+			l.unlock();
+			const auto line = current ? current->getLine(nextTick / linePeriod - 1) : std::nullopt;
+			l.lock();
+			if (stop || inPause || clockVersion != clock.getVersion() || current != content) {
+				continue; // the line is not the one to output anymore
+			}
+			if (!line) {
+				inPause = true;
+				clock.pause();
+				clock.seek(0s);
 				if (onMusicFinished) {
-					onMusicFinished();
+					// Not under `mutex`, nor on this thread: it may open the next track.
+					dispatcher.post(onMusicFinished);
 				}
 				continue;
 			}
-			this->os << content[static_cast<std::size_t>(elapsedTime.count())] << "\n";
-			elapsedTime += 1s;
+			this->os << *line << "\n";
+			nextTick += linePeriod;
 		}
 	});
+	prefetchThread = std::thread([this]() { runPrefetch(); });
 }
 
 //------------------------------------------------------------------------------
 ThreadMusicPlayer::~ThreadMusicPlayer()
 {
-	stop = true;
+	{
+		std::lock_guard l{mutex};
+		stop = true;
+	}
+	stateChanged.notify_all();
+	{
+		std::lock_guard l{prefetchMutex}; // so runPrefetch either sees `stop` or is waiting
+	}
+	prefetchCv.notify_all();
+	prefetchThread.join();
 	thread.join();
+	dispatcher.stop();
 }
 
 //------------------------------------------------------------------------------
 bool ThreadMusicPlayer::openMusic(const std::filesystem::path& p)
 {
+	auto newContent = takePrefetched(p);
+	if (!newContent) {
+		newContent = openTrackContent(p, loading); // without locking
+	}
 	std::lock_guard l{mutex};
 
-	content.clear();
-	elapsedTime = 0s;
-	std::ifstream file(p);
-	std::string line;
-
-	if (!std::getline(file, line)) {
-		return false;
-	}
-	while (std::getline(file, line)) {
-		content.push_back(std::move(line));
-	}
-	return true;
+	content = std::move(newContent);
+	clock.seek(0s);
+	stateChanged.notify_all();
+	return content != nullptr;
 }
 //------------------------------------------------------------------------------
 void ThreadMusicPlayer::pause()
 {
-	inPause = true;
+	{
+		std::lock_guard l{mutex};
+		inPause = true;
+		clock.pause();
+	}
+	stateChanged.notify_all();
 }
 //------------------------------------------------------------------------------
 void ThreadMusicPlayer::play()
 {
-	inPause = false;
+	{
+		std::lock_guard l{mutex};
+		inPause = false;
+		clock.start();
+	}
+	stateChanged.notify_all();
 }
 //------------------------------------------------------------------------------
 void ThreadMusicPlayer::setElapsedTime(const std::chrono::seconds& t)
 {
-	std::lock_guard l{mutex};
-	elapsedTime = t;
+	seek(t);
 }
 //------------------------------------------------------------------------------
 std::chrono::seconds ThreadMusicPlayer::getElapsedTime()
 {
-	std::lock_guard l{mutex};
-	return elapsedTime;
+	return std::chrono::floor<std::chrono::seconds>(clock.getPosition());
+}
+//------------------------------------------------------------------------------
+std::chrono::milliseconds ThreadMusicPlayer::getPosition()
+{
+	return std::chrono::floor<std::chrono::milliseconds>(clock.getPosition());
+}
+//------------------------------------------------------------------------------
+void ThreadMusicPlayer::seek(std::chrono::milliseconds position)
+{
+	{
+		std::lock_guard l{mutex};
+		clock.seek(position);
+	}
+	stateChanged.notify_all();
 }
 //------------------------------------------------------------------------------
 void ThreadMusicPlayer::setOnMusicFinished(std::function<void()> f)
@@ -89,4 +144,51 @@ void ThreadMusicPlayer::setOnMusicFinished(std::function<void()> f)
 	onMusicFinished = std::move(f);
 }
 
+//------------------------------------------------------------------------------
+void ThreadMusicPlayer::prefetch(const std::filesystem::path& p)
+{
+	{
+		std::lock_guard l{prefetchMutex};
+		if (p == prefetchedPath || p == loadingPath) {
+			return;
+		}
+		prefetchRequest = p;
+	}
+	prefetchCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+void ThreadMusicPlayer::runPrefetch()
+{
+	std::unique_lock l{prefetchMutex};
+	while (true) {
+		prefetchCv.wait(l, [this]() { return stop || prefetchRequest; });
+		if (stop) {
+			return;
+		}
+		loadingPath = std::move(*prefetchRequest);
+		prefetchRequest.reset();
+		l.unlock();
+		auto loaded = openTrackContent(loadingPath, loading);
+		l.lock();
+		prefetchedPath = std::exchange(loadingPath, {});
+		prefetchedContent = std::move(loaded);
+		prefetchCv.notify_all();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Prefetched content of `p`, waiting for it if it is being loaded.
+// nullptr if not prefetched (or not readable).
+std::unique_ptr<TrackContent> ThreadMusicPlayer::takePrefetched(const std::filesystem::path& p)
+{
+	std::unique_lock l{prefetchMutex};
+	prefetchCv.wait(l, [&]() { return stop || (prefetchRequest != p && loadingPath != p); });
+	if (prefetchedPath != p) {
+		return nullptr;
+	}
+	prefetchedPath.clear();
+	return std::move(prefetchedContent);
+}
+
 } // namespace iplayer
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "eventdispatcher.h"
 #include "imusicplayer.h"
+#include "playbackclock.h"
+#include "trackcontent.h"
 
+#include <condition_variable>
 #include <mutex>
+#include <optional>
 #include <thread>
 
 namespace iplayer
@@ -11,7 +16,9 @@ namespace iplayer
 class ThreadMusicPlayer : public IMusicPlayer
 {
 public:
-	explicit ThreadMusicPlayer(std::ostream& os);
+	explicit ThreadMusicPlayer(std::ostream& os,
+	                           TrackLoading = TrackLoading::Full,
+	                           std::chrono::nanoseconds linePeriod = std::chrono::seconds(1));
 	~ThreadMusicPlayer();
 
 	ThreadMusicPlayer(const ThreadMusicPlayer&) = delete;
@@ -22,17 +29,38 @@ public:
 	void play() override;
 	void setElapsedTime(const std::chrono::seconds&) override;
 	std::chrono::seconds getElapsedTime() override;
+	std::chrono::milliseconds getPosition() override; // lock-free
+	void seek(std::chrono::milliseconds) override;
 	void setOnMusicFinished(std::function<void()>) override;
+	void prefetch(const std::filesystem::path&) override;
+
+private:
+	void runPrefetch();
+	std::unique_ptr<TrackContent> takePrefetched(const std::filesystem::path&);
 
 private:
 	std::thread thread;
 	std::ostream& os;
+	const TrackLoading loading;
+	const std::chrono::nanoseconds linePeriod; // one line output by period
 	std::atomic<bool> stop = false;
 	std::function<void()> onMusicFinished;
 	std::atomic<bool> inPause = true;
 	std::recursive_mutex mutex;
-	std::vector<std::string> content;
-	std::chrono::seconds elapsedTime{};
+	std::condition_variable_any stateChanged; // for `stop` and `inPause`
+	std::shared_ptr<TrackContent> content; // shared with the thread while it reads a line
+	PlaybackClock clock; // written under `mutex`
+
+	// Single slot prefetcher: a new request replaces the previous one.
+	std::mutex prefetchMutex;
+	std::condition_variable prefetchCv;
+	std::optional<std::filesystem::path> prefetchRequest;
+	std::filesystem::path loadingPath; // empty when idle
+	std::filesystem::path prefetchedPath;
+	std::unique_ptr<TrackContent> prefetchedContent;
+	std::thread prefetchThread;
+
+	EventDispatcher dispatcher; // for onMusicFinished
 };
 
 } // namespace iplayer
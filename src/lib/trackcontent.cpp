@@ -0,0 +1,93 @@
+#include "trackcontent.h"
+
+#include "binarytrack.h"
+#include "mappedfile.h"
+#include "newlinescan.h"
+#include "streamingtrackcontent.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+/* Whole text file mapped in memory, with the positions of its line ends.
+   Same lines as successive std::getline calls. */
+class MappedTrackContent : public iplayer::TrackContent
+{
+public:
+	explicit MappedTrackContent(iplayer::MappedFile&& mappedFile) : file(std::move(mappedFile))
+	{
+		const auto data = file.data();
+		iplayer::findNewlines(data, lineEnds); // first one ends the header
+		if (data.back() != '\n') {
+			lineEnds.push_back(data.size()); // last line without end of line
+		}
+	}
+
+	std::optional<std::string_view> getLine(std::size_t n) override
+	{
+		if (lineEnds.size() <= n + 1) {
+			return std::nullopt;
+		}
+		return file.data().substr(lineEnds[n] + 1, lineEnds[n + 1] - lineEnds[n] - 1);
+	}
+
+private:
+	iplayer::MappedFile file;
+	std::vector<std::size_t> lineEnds;
+};
+
+/* Mapped file, lines are not copied. */
+class BinaryTrackContent : public iplayer::TrackContent
+{
+public:
+	explicit BinaryTrackContent(iplayer::BinaryTrack&& track) : track(std::move(track)) {}
+
+	std::optional<std::string_view> getLine(std::size_t n) override
+	{
+		return n < track.getLineCount() ? std::optional(track.getLine(n)) : std::nullopt;
+	}
+
+private:
+	iplayer::BinaryTrack track;
+};
+
+} // namespace
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+std::unique_ptr<TrackContent> openTrackContent(const std::filesystem::path& path,
+                                               TrackLoading loading)
+{
+	if (loading == TrackLoading::Streaming) {
+		std::ifstream file(path);
+		std::string line;
+
+		if (!std::getline(file, line)) {
+			return nullptr;
+		}
+		if (!BinaryTrack::hasMagic(line)) {
+			return std::make_unique<StreamingTrackContent>(std::move(file));
+		}
+	} else {
+		MappedFile file(path);
+
+		if (!file.isOpen() || file.data().empty()) {
+			return nullptr;
+		}
+		if (!BinaryTrack::hasMagic(file.data())) {
+			return std::make_unique<MappedTrackContent>(std::move(file));
+		}
+	}
+	BinaryTrack track(path);
+	if (!track.isOpen()) {
+		return nullptr;
+	}
+	return std::make_unique<BinaryTrackContent>(std::move(track));
+}
+
+} // namespace iplayer
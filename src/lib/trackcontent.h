@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace iplayer
+{
+
+/* Lines of a track, following its header, whatever the file format. */
+class TrackContent
+{
+public:
+	virtual ~TrackContent() = default;
+
+	// nullopt past the end. The line is valid until the next call.
+	virtual std::optional<std::string_view> getLine(std::size_t) = 0;
+};
+
+enum class TrackLoading
+{
+	Full, // whole text file is mapped in memory
+	Streaming // bounded memory, see StreamingTrackContent
+};
+
+// Text or binary track (see BinaryTrack, always mapped);
+// nullptr if the file cannot be opened or has no header.
+std::unique_ptr<TrackContent> openTrackContent(const std::filesystem::path&,
+                                               TrackLoading = TrackLoading::Full);
+
+} // namespace iplayer
@@ -1,20 +1,178 @@
 #include "trackheader.h"
 
+#include "binarytrack.h"
+#include "headercache.h"
+#include "headerparsing.h"
+#include "trackmetadata.h"
+
+#include <charconv>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <string_view>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+constexpr std::size_t headerReadSize = 512; // longer headers are read with std::getline
+
+using iplayer::TrackHeaderError;
+
+//------------------------------------------------------------------------------
+// Read the beginning of the file, nullopt if it cannot be opened.
+std::optional<std::size_t> readPrefix(const std::filesystem::path& path, char* buffer, std::size_t size)
+{
+#ifdef _WIN32
+	std::FILE* file = _wfopen(path.c_str(), L"rb");
+	if (!file) {
+		return std::nullopt;
+	}
+	const auto res = std::fread(buffer, 1, size, file);
+	std::fclose(file);
+	return res;
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return std::nullopt;
+	}
+	const auto res = ::pread(fd, buffer, size, 0);
+	::close(fd);
+	return res < 0 ? 0 : static_cast<std::size_t>(res); // as directories: opened but unreadable
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Same grammar as `is >> std::quoted(title) >> seconds`.
+// `parsedSize` is set to the offset following the duration.
+std::optional<TrackHeaderError>
+parseHeaderLine(std::string_view line, std::string& title, int& seconds, std::size_t& parsedSize)
+{
+	auto it = line.begin();
+	const auto end = line.end();
+	auto offset = [&]() { return static_cast<std::size_t>(it - line.begin()); };
+
+	iplayer::skipHeaderSpaces(it, end);
+	if (it == end) {
+		return TrackHeaderError{TrackHeaderError::Code::Empty, offset()};
+	}
+	const auto titleOffset = offset();
+	if (!iplayer::readHeaderWord(it, end, title)) {
+		return TrackHeaderError{TrackHeaderError::Code::BadQuoting, titleOffset};
+	}
+
+	iplayer::skipHeaderSpaces(it, end);
+	const auto durationOffset = offset();
+	if (it != end && *it == '+') { // accepted by operator>>, not by from_chars
+		++it;
+		if (it == end || *it == '-') {
+			return TrackHeaderError{TrackHeaderError::Code::BadDuration, durationOffset};
+		}
+	}
+	const auto rest = line.substr(offset());
+	const auto [ptr, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), seconds);
+	if (ec != std::errc()) {
+		return TrackHeaderError{TrackHeaderError::Code::BadDuration, durationOffset};
+	}
+	parsedSize = static_cast<std::size_t>(ptr - line.data());
+	return std::nullopt;
+}
+
+//------------------------------------------------------------------------------
+// First line of the file, nullopt if it cannot be opened.
+// The view is in `buffer`, or in `longLine` when the line does not fit.
+std::optional<std::string_view>
+readFirstLine(const std::filesystem::path& path,
+              char (&buffer)[headerReadSize],
+              std::string& longLine)
+{
+	const auto size = readPrefix(path, buffer, sizeof(buffer));
+
+	if (!size) {
+		return std::nullopt;
+	}
+	const std::string_view content(buffer, *size);
+	const auto eol = content.find('\n');
+	if (eol == std::string_view::npos && *size == sizeof(buffer)) {
+		std::ifstream file(path);
+		if (!std::getline(file, longLine)) {
+			return std::nullopt;
+		}
+		return longLine;
+	}
+	return content.substr(0, eol);
+}
+
+//------------------------------------------------------------------------------
+std::optional<TrackHeaderError> readHeader(const std::filesystem::path& path, iplayer::TrackHeader& out)
+{
+	char buffer[headerReadSize];
+	std::string longLine;
+	const auto line = readFirstLine(path, buffer, longLine);
+
+	if (!line) {
+		return TrackHeaderError{TrackHeaderError::Code::NotFound};
+	}
+	if (iplayer::BinaryTrack::hasMagic(*line)) {
+		const iplayer::BinaryTrack track(path);
+		if (!track.isOpen()) {
+			return TrackHeaderError{TrackHeaderError::Code::Corrupted};
+		}
+		out.filename = path;
+		out.title = track.getTitle();
+		out.duration = track.getDuration();
+		return std::nullopt;
+	}
+	int seconds = 0;
+	std::size_t parsedSize = 0;
+	if (auto error = parseHeaderLine(*line, out.title, seconds, parsedSize)) {
+		return error;
+	}
+	out.filename = path;
+	out.duration = std::chrono::seconds(seconds);
+	return std::nullopt;
+}
+
+} // namespace
 
 namespace iplayer
 {
 
 //------------------------------------------------------------------------------
-TrackHeader openTrackHeader(const std::filesystem::path& path)
+const char* toString(TrackHeaderError::Code code)
 {
-	std::ifstream file(path);
+	switch (code) {
+		case TrackHeaderError::Code::NotFound: return "File not found";
+		case TrackHeaderError::Code::Empty: return "Empty header";
+		case TrackHeaderError::Code::BadQuoting: return "Bad title quoting";
+		case TrackHeaderError::Code::BadDuration: return "Bad duration";
+		case TrackHeaderError::Code::Corrupted: return "Corrupted binary track";
+	}
+	return "Unknown error";
+}
 
-	if (!file) {
-		throw std::runtime_error("File not found"); // Use dedicated exception instead
+//------------------------------------------------------------------------------
+TrackHeaderException::TrackHeaderException(const TrackHeaderError& error) :
+	std::runtime_error(error.code == TrackHeaderError::Code::NotFound
+	                       ? std::string(toString(error.code))
+	                       : "Invalid format: " + std::string(toString(error.code)) + " at offset "
+	                             + std::to_string(error.offset)),
+	error(error)
+{}
+
+//------------------------------------------------------------------------------
+TrackHeader openTrackHeader(const std::filesystem::path& path)
+{
+	TrackHeader res;
+	TrackHeaderError error;
+	if (!readTrackHeader(path, res, error)) {
+		throw TrackHeaderException(error);
 	}
-	return openTrackHeader(path, file);
+	return res;
 }
 
 //------------------------------------------------------------------------------
@@ -36,6 +194,73 @@ TrackHeader openTrackHeader(const std::filesystem::path& path, std::istream& is)
 	return res;
 }
 
+//------------------------------------------------------------------------------
+TrackHeaderResult tryOpenTrackHeader(const std::filesystem::path& path)
+{
+	TrackHeader res;
+	TrackHeaderError error;
+	if (!readTrackHeader(path, res, error)) {
+		return Unexpected<TrackHeaderError>{error};
+	}
+	return res;
+}
+
+//------------------------------------------------------------------------------
+std::vector<TrackHeaderResult> tryOpenTrackHeaders(std::span<const std::filesystem::path> paths)
+{
+	std::vector<TrackHeaderResult> res;
+	res.reserve(paths.size());
+	for (const auto& path : paths) {
+		res.push_back(tryOpenTrackHeader(path));
+	}
+	return res;
+}
+
+//------------------------------------------------------------------------------
+bool readTrackHeader(const std::filesystem::path& path, TrackHeader& out)
+{
+	TrackHeaderError error;
+	return readTrackHeader(path, out, error);
+}
+
+//------------------------------------------------------------------------------
+bool readTrackHeader(const std::filesystem::path& path, TrackHeader& out, TrackHeaderError& error)
+{
+	auto& cache = HeaderCache::global();
+	if (cache.lookup(path, out)) {
+		return true;
+	}
+	if (auto readError = readHeader(path, out)) {
+		error = *readError;
+		return false;
+	}
+	cache.store(out);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+std::optional<TrackMetadata> readTrackMetadata(const std::filesystem::path& path)
+{
+	char buffer[headerReadSize];
+	std::string longLine;
+	const auto line = readFirstLine(path, buffer, longLine);
+
+	if (!line) {
+		return std::nullopt;
+	}
+	if (BinaryTrack::hasMagic(*line)) {
+		const BinaryTrack track(path);
+		return track.isOpen() ? std::optional(parseTrackMetadata(track.getMetadata())) : std::nullopt;
+	}
+	std::string title;
+	int seconds = 0;
+	std::size_t parsedSize = 0;
+	if (parseHeaderLine(*line, title, seconds, parsedSize)) {
+		return std::nullopt;
+	}
+	return parseTrackMetadata(line->substr(parsedSize));
+}
+
 //------------------------------------------------------------------------------
 void infoTrack(std::ostream& os, const TrackHeader& track)
 {
@@ -43,6 +268,16 @@ void infoTrack(std::ostream& os, const TrackHeader& track)
 	   << "Title: " << track.title << "\n"
 	   << "Duration: " << track.duration.count() << "s"
 	   << "\n";
+	const auto metadata = TrackMetadataCache::global().get(track.filename);
+	if (!metadata->album.empty()) {
+		os << "Album: " << metadata->album << "\n";
+	}
+	if (!metadata->artist.empty()) {
+		os << "Artist: " << metadata->artist << "\n";
+	}
+	if (!metadata->codec.empty()) {
+		os << "Codec: " << metadata->codec << "\n";
+	}
 }
 
 } // namespace iplayer
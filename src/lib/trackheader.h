@@ -1,25 +1,75 @@
 #pragma once
 
+#include "expected.h"
+#include "internedpath.h"
+
 #include <chrono>
 #include <filesystem>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <iostream>
+#include <vector>
 
 namespace iplayer
 {
 
 struct TrackHeader
 {
-	std::filesystem::path filename;
+	InternedPath filename;
 	std::string title;
 	std::chrono::seconds duration;
-	// other metadata (codec, album, ID3vx, Lyrics...)
+	// other metadata (codec, album, ID3vx, Lyrics...) are loaded on demand,
+	// see TrackMetadataCache.
 
 	bool operator==(const TrackHeader&) const = default;
 };
 
+struct TrackHeaderError
+{
+	enum class Code
+	{
+		NotFound,
+		Empty,
+		BadQuoting,
+		BadDuration,
+		Corrupted // binary track
+	};
+	Code code = Code::NotFound;
+	std::size_t offset = 0; // in bytes, from the beginning of the file
+
+	bool operator==(const TrackHeaderError&) const = default;
+};
+const char* toString(TrackHeaderError::Code);
+
+class TrackHeaderException : public std::runtime_error
+{
+public:
+	explicit TrackHeaderException(const TrackHeaderError&);
+
+	const TrackHeaderError& getError() const { return error; }
+
+private:
+	TrackHeaderError error;
+};
+
+// Throw TrackHeaderException.
 TrackHeader openTrackHeader(const std::filesystem::path&);
+// Throw std::runtime_error.
 TrackHeader openTrackHeader(const std::filesystem::path&, std::istream&);
+
+// Non-throwing versions (except for std::bad_alloc).
+using TrackHeaderResult = Expected<TrackHeader, TrackHeaderError>;
+TrackHeaderResult tryOpenTrackHeader(const std::filesystem::path&);
+std::vector<TrackHeaderResult> tryOpenTrackHeaders(std::span<const std::filesystem::path>);
+
+// Fast path: a single small read of the first line, parsed without stream nor locale,
+// `out.title` storage is reused. Return false if file is missing or header invalid.
+bool readTrackHeader(const std::filesystem::path&, TrackHeader& out);
+bool readTrackHeader(const std::filesystem::path&, TrackHeader& out, TrackHeaderError& error);
+// All functions above, except the stream-based one, first look in HeaderCache::global(),
+// once opened.
+
 void infoTrack(std::ostream&, const TrackHeader&);
 
 } // namespace iplayer
@@ -0,0 +1,98 @@
+#include "trackmetadata.h"
+
+#include "headerparsing.h"
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+TrackMetadata parseTrackMetadata(std::string_view s)
+{
+	TrackMetadata res;
+	auto it = s.begin();
+	const auto end = s.end();
+
+	while (true) {
+		skipHeaderSpaces(it, end);
+		const auto keyBegin = it;
+		while (it != end && *it != '=' && !isHeaderSpace(*it)) {
+			++it;
+		}
+		if (it == end || *it != '=' || it == keyBegin) {
+			return res;
+		}
+		const std::string key(keyBegin, it);
+		++it;
+		std::string value;
+		if (!readHeaderWord(it, end, value)) {
+			return res; // unterminated quote
+		}
+
+		if (key == "album") {
+			res.album = std::move(value);
+		} else if (key == "artist") {
+			res.artist = std::move(value);
+		} else if (key == "codec") {
+			res.codec = std::move(value);
+		} else {
+			res.others.emplace_back(key, std::move(value));
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+TrackMetadataCache& TrackMetadataCache::global()
+{
+	static TrackMetadataCache cache;
+	return cache;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const TrackMetadata> TrackMetadataCache::get(const InternedPath& path)
+{
+	{
+		std::lock_guard l(mutex);
+		if (auto it = entriesByPath.find(path); it != entriesByPath.end()) {
+			entries.splice(entries.begin(), entries, it->second);
+			return it->second->second;
+		}
+	}
+	// Read outside of the lock; concurrent misses for the same path just read it twice.
+	auto metadata =
+		std::make_shared<const TrackMetadata>(readTrackMetadata(path).value_or(TrackMetadata{}));
+
+	std::lock_guard l(mutex);
+	if (auto it = entriesByPath.find(path); it != entriesByPath.end()) {
+		entries.splice(entries.begin(), entries, it->second);
+		return it->second->second;
+	}
+	if (capacity == 0) {
+		return metadata;
+	}
+	if (entries.size() == capacity) {
+		entriesByPath.erase(entries.back().first);
+		entries.pop_back();
+	}
+	entries.emplace_front(path, metadata);
+	entriesByPath.emplace(path, entries.begin());
+	return metadata;
+}
+
+//------------------------------------------------------------------------------
+void TrackMetadataCache::invalidate(const InternedPath& path)
+{
+	std::lock_guard l(mutex);
+	if (auto it = entriesByPath.find(path); it != entriesByPath.end()) {
+		entries.erase(it->second);
+		entriesByPath.erase(it);
+	}
+}
+
+//------------------------------------------------------------------------------
+std::size_t TrackMetadataCache::size()
+{
+	std::lock_guard l(mutex);
+	return entries.size();
+}
+
+} // namespace iplayer
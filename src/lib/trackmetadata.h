@@ -0,0 +1,63 @@
+#pragma once
+
+#include "internedpath.h"
+
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace iplayer
+{
+
+/* Metadata which are not needed to build or sort playlists,
+   given as `key="value"` pairs after the duration on the track header line. */
+struct TrackMetadata
+{
+	std::string album;
+	std::string artist;
+	std::string codec;
+	std::vector<std::pair<std::string, std::string>> others; // unknown keys, in file order
+
+	bool operator==(const TrackMetadata&) const = default;
+};
+
+// Parse space separated `key="value"` (or `key=value`) pairs, stopping at the first malformed one.
+TrackMetadata parseTrackMetadata(std::string_view);
+// Read the header line of the file; nullopt if the header cannot be read.
+// Implemented with the header parser, in trackheader.cpp.
+std::optional<TrackMetadata> readTrackMetadata(const std::filesystem::path&);
+
+/* Metadata loaded on first access and kept for the `capacity` most recently used tracks.
+   TrackHeader only holds the eager fields,
+   so comparing or deduplicating tracks never loads them. */
+class TrackMetadataCache
+{
+public:
+	static TrackMetadataCache& global();
+
+	explicit TrackMetadataCache(std::size_t capacity = 1024) : capacity(capacity) {}
+
+	// Empty metadata if the file cannot be read.
+	std::shared_ptr<const TrackMetadata> get(const InternedPath&);
+	// To call when the file changed.
+	void invalidate(const InternedPath&);
+
+	std::size_t size();
+
+private:
+	using Entry = std::pair<InternedPath, std::shared_ptr<const TrackMetadata>>;
+
+	std::size_t capacity;
+	std::mutex mutex;
+	std::list<Entry> entries; // most recently used first
+	std::unordered_map<InternedPath, std::list<Entry>::iterator> entriesByPath;
+};
+
+} // namespace iplayer
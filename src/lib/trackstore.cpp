@@ -0,0 +1,55 @@
+#include "trackstore.h"
+
+#include <algorithm>
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+TrackStore& TrackStore::global()
+{
+	static TrackStore store;
+	return store;
+}
+
+//------------------------------------------------------------------------------
+TrackRef TrackStore::intern(TrackHeader&& track)
+{
+	const auto hash = track.filename.hash();
+	std::lock_guard l(mutex);
+
+	auto [first, last] = headers.equal_range(hash);
+	for (auto it = first; it != last;) {
+		if (auto ref = it->second.lock()) {
+			if (*ref == track) {
+				return ref;
+			}
+			++it;
+		} else {
+			it = headers.erase(it);
+		}
+	}
+	auto ref = std::make_shared<const TrackHeader>(std::move(track));
+	headers.emplace(hash, ref);
+	if (purgeThreshold <= headers.size()) {
+		purge();
+	}
+	return ref;
+}
+
+//------------------------------------------------------------------------------
+std::size_t TrackStore::size()
+{
+	std::lock_guard l(mutex);
+	purge();
+	return headers.size();
+}
+
+//------------------------------------------------------------------------------
+void TrackStore::purge()
+{
+	std::erase_if(headers, [](const auto& p) { return p.second.expired(); });
+	purgeThreshold = std::max<std::size_t>(1024, 2 * headers.size());
+}
+
+} // namespace iplayer
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "trackheader.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace iplayer
+{
+
+using TrackRef = std::shared_ptr<const TrackHeader>;
+
+/* Process-wide pool of immutable track headers.
+   Identical headers are stored once and shared (by reference counting) between
+   playlists and players; an entry is released with its last reference. */
+class TrackStore
+{
+public:
+	static TrackStore& global();
+
+	TrackRef intern(TrackHeader&&);
+
+	std::size_t size(); // number of live headers
+
+private:
+	void purge();
+
+private:
+	std::mutex mutex;
+	std::unordered_multimap<std::size_t, std::weak_ptr<const TrackHeader>> headers; // by filename hash
+	std::size_t purgeThreshold = 1024;
+};
+
+} // namespace iplayer
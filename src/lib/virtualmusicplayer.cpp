@@ -0,0 +1,117 @@
+#include "virtualmusicplayer.h"
+
+using namespace std::literals;
+
+namespace iplayer
+{
+
+//------------------------------------------------------------------------------
+VirtualMusicPlayer::VirtualMusicPlayer(PlaybackEngine& engine, std::ostream& os,
+                                       std::chrono::nanoseconds linePeriod) :
+	engine(engine),
+	os(os),
+	linePeriod(std::max(linePeriod, 1ns))
+{}
+
+//------------------------------------------------------------------------------
+VirtualMusicPlayer::~VirtualMusicPlayer()
+{
+	engine.cancelAndWait(tick);
+}
+
+//------------------------------------------------------------------------------
+bool VirtualMusicPlayer::openMusic(const std::filesystem::path& p)
+{
+	auto newContent = openTrackContent(p); // without locking
+	std::lock_guard l{mutex};
+
+	content = std::move(newContent);
+	clock.seek(0s, engine.now());
+	reschedule();
+	return content != nullptr;
+}
+//------------------------------------------------------------------------------
+void VirtualMusicPlayer::pause()
+{
+	std::lock_guard l{mutex};
+	inPause = true;
+	clock.pause(engine.now());
+	reschedule();
+}
+//------------------------------------------------------------------------------
+void VirtualMusicPlayer::play()
+{
+	std::lock_guard l{mutex};
+	inPause = false;
+	clock.start(engine.now());
+	reschedule();
+}
+//------------------------------------------------------------------------------
+void VirtualMusicPlayer::setElapsedTime(const std::chrono::seconds& t)
+{
+	seek(t);
+}
+//------------------------------------------------------------------------------
+std::chrono::seconds VirtualMusicPlayer::getElapsedTime()
+{
+	return std::chrono::floor<std::chrono::seconds>(clock.getPosition(engine.now()));
+}
+//------------------------------------------------------------------------------
+std::chrono::milliseconds VirtualMusicPlayer::getPosition()
+{
+	return std::chrono::floor<std::chrono::milliseconds>(clock.getPosition(engine.now()));
+}
+//------------------------------------------------------------------------------
+void VirtualMusicPlayer::seek(std::chrono::milliseconds position)
+{
+	std::lock_guard l{mutex};
+	clock.seek(position, engine.now());
+	reschedule();
+}
+//------------------------------------------------------------------------------
+void VirtualMusicPlayer::setOnMusicFinished(std::function<void()> f)
+{
+	std::lock_guard l{mutex};
+	onMusicFinished = std::move(f);
+}
+
+//------------------------------------------------------------------------------
+void VirtualMusicPlayer::reschedule()
+{
+	if (inPause) {
+		engine.cancel(tick); // a running tick sees `inPause`
+		return;
+	}
+	nextLineTime = (clock.getPosition(engine.now()) / linePeriod + 1) * linePeriod;
+	engine.schedule(tick, clock.timeAt(nextLineTime));
+}
+
+//------------------------------------------------------------------------------
+// The timer may be late, or early if the state changed meanwhile: only the state matters.
+void VirtualMusicPlayer::onTick()
+{
+	std::unique_lock l{mutex};
+	if (inPause) {
+		return;
+	}
+	const auto now = engine.now();
+	while (clock.getPosition(now) >= nextLineTime) {
+		const auto line = content ? content->getLine(nextLineTime / linePeriod - 1) : std::nullopt;
+		if (!line) {
+			inPause = true;
+			clock.pause(now);
+			clock.seek(0s, now);
+			const auto f = onMusicFinished;
+			l.unlock();
+			if (f) {
+				f();
+			}
+			return;
+		}
+		os << *line << "\n";
+		nextLineTime += linePeriod;
+	}
+	engine.schedule(tick, clock.timeAt(nextLineTime));
+}
+
+} // namespace iplayer
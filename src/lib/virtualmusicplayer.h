@@ -0,0 +1,67 @@
+#pragma once
+
+#include "imusicplayer.h"
+#include "playbackclock.h"
+#include "playbackengine.h"
+#include "trackcontent.h"
+
+#include <mutex>
+#include <ostream>
+
+namespace iplayer
+{
+
+/* Music player without thread of its own: lines are output by the timers of a PlaybackEngine,
+   so that thousands of players can share a few threads (a few hundred bytes each, plus the
+   track content, always mapped: see TrackLoading::Full).
+   Output and onMusicFinished happen on the threads of the engine, which must outlive the player,
+   and follow its time (simulated if the engine has no thread).
+   onMusicFinished may open and play the next track, but not destroy the player. */
+class VirtualMusicPlayer : public IMusicPlayer
+{
+public:
+	explicit VirtualMusicPlayer(PlaybackEngine&, std::ostream&,
+	                            std::chrono::nanoseconds linePeriod = std::chrono::seconds(1));
+	~VirtualMusicPlayer() override;
+
+	VirtualMusicPlayer(const VirtualMusicPlayer&) = delete;
+	VirtualMusicPlayer& operator=(const VirtualMusicPlayer&) = delete;
+
+	bool openMusic(const std::filesystem::path&) override;
+	void pause() override;
+	void play() override;
+	void setElapsedTime(const std::chrono::seconds&) override;
+	std::chrono::seconds getElapsedTime() override;
+	std::chrono::milliseconds getPosition() override; // lock-free
+	void seek(std::chrono::milliseconds) override;
+	void setOnMusicFinished(std::function<void()>) override;
+
+private:
+	class Tick : public PlaybackEngine::Timer
+	{
+	public:
+		explicit Tick(VirtualMusicPlayer& player) : player(player) {}
+
+	private:
+		void onTimer() override { player.onTick(); }
+
+		VirtualMusicPlayer& player;
+	};
+
+	void onTick();
+	void reschedule(); // with lock
+
+private:
+	PlaybackEngine& engine;
+	std::ostream& os;
+	const std::chrono::nanoseconds linePeriod;
+	std::mutex mutex;
+	std::function<void()> onMusicFinished;
+	std::unique_ptr<TrackContent> content;
+	PlaybackClock clock; // written under `mutex`
+	std::chrono::nanoseconds nextLineTime{}; // line n is output at (n + 1) periods
+	bool inPause = true;
+	Tick tick{*this};
+};
+
+} // namespace iplayer
@@ -0,0 +1,100 @@
+#include "binarytrack.h"
+
+#include "trackcontent.h"
+#include "trackheader.h"
+#include "trackmetadata.h"
+
+#include <doctest.h>
+#include <fstream>
+
+using namespace std::literals;
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+std::vector<std::string> readLines(iplayer::TrackContent& content)
+{
+	std::vector<std::string> res;
+	for (std::size_t i = 0; const auto line = content.getLine(i); ++i) {
+		res.emplace_back(*line);
+	}
+	return res;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+TEST_CASE("BinaryTrack")
+{
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path() / "iplayer-test-binary";
+	std::filesystem::create_directories(tmpDir);
+	const std::vector<std::string> lines{"La", "", "La la la"};
+	{
+		std::ofstream os(tmpDir / "track.bin", std::ios::binary);
+		iplayer::writeBinaryTrack(os, "Some title", 42s, R"( album="Album")", lines);
+	}
+	const iplayer::BinaryTrack track(tmpDir / "track.bin");
+
+	REQUIRE(track.isOpen());
+	CHECK_EQ("Some title", track.getTitle());
+	CHECK_EQ(42s, track.getDuration());
+	REQUIRE_EQ(lines.size(), track.getLineCount());
+	for (std::size_t i = 0; i != lines.size(); ++i) {
+		CHECK_EQ(lines[i], track.getLine(i));
+	}
+	CHECK(track.getLine(3).empty());
+
+	// Transparent support
+	const auto header = iplayer::openTrackHeader(tmpDir / "track.bin");
+	CHECK_EQ("Some title", header.title);
+	CHECK_EQ(42s, header.duration);
+	CHECK_EQ("Album", iplayer::readTrackMetadata(tmpDir / "track.bin")->album);
+	const auto content = iplayer::openTrackContent(tmpDir / "track.bin");
+	REQUIRE(content);
+	CHECK_EQ(lines, readLines(*content));
+
+	// Truncated file
+	std::filesystem::resize_file(tmpDir / "track.bin",
+	                             std::filesystem::file_size(tmpDir / "track.bin") - 1);
+	CHECK_FALSE(iplayer::BinaryTrack(tmpDir / "track.bin").isOpen());
+	const auto result = iplayer::tryOpenTrackHeader(tmpDir / "track.bin");
+	REQUIRE_FALSE(result.has_value());
+	CHECK_EQ(iplayer::TrackHeaderError{iplayer::TrackHeaderError::Code::Corrupted},
+	         result.error());
+	CHECK_FALSE(iplayer::openTrackContent(tmpDir / "track.bin"));
+
+	std::filesystem::remove_all(tmpDir);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("convertTrack")
+{
+	// working dir is at solution/$buildsystem/
+	const std::filesystem::path dataDir = "../../data";
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path() / "iplayer-test-convert";
+	std::filesystem::create_directories(tmpDir);
+
+	for (const auto* name : {"track1", "track2", "track3", "track4"}) {
+		CAPTURE(name);
+		REQUIRE(iplayer::convertTrack(dataDir / name, tmpDir / "binary", iplayer::TrackFormat::Binary));
+		REQUIRE(iplayer::convertTrack(tmpDir / "binary", tmpDir / "text", iplayer::TrackFormat::Text));
+
+		const auto expectedHeader = iplayer::openTrackHeader(dataDir / name);
+		const auto binaryHeader = iplayer::openTrackHeader(tmpDir / "binary");
+		CHECK_EQ(expectedHeader.title, binaryHeader.title);
+		CHECK_EQ(expectedHeader.duration, binaryHeader.duration);
+
+		const auto expected = iplayer::openTrackContent(dataDir / name);
+		const auto binary = iplayer::openTrackContent(tmpDir / "binary");
+		const auto text = iplayer::openTrackContent(tmpDir / "text");
+		REQUIRE(binary);
+		REQUIRE(text);
+		CHECK_EQ(readLines(*expected), readLines(*binary));
+		CHECK_EQ(readLines(*expected), readLines(*text));
+	}
+	CHECK_FALSE(
+		iplayer::convertTrack(dataDir / "invalid1", tmpDir / "binary", iplayer::TrackFormat::Binary));
+
+	std::filesystem::remove_all(tmpDir);
+}
@@ -0,0 +1,50 @@
+#include "eventdispatcher.h"
+
+#include <doctest.h>
+#include <future>
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("EventDispatcher")
+{
+	constexpr int producerCount = 4;
+	constexpr int taskCount = 10000;
+	std::vector<std::vector<int>> received(producerCount); // only written by the dispatcher
+	std::thread::id dispatcherThreadId;
+	bool sameThread = true;
+	iplayer::EventDispatcher dispatcher;
+
+	std::vector<std::thread> producers;
+	for (int p = 0; p != producerCount; ++p) {
+		producers.emplace_back([&, p]() {
+			for (int i = 0; i != taskCount; ++i) {
+				dispatcher.post([&, p, i]() {
+					received[p].push_back(i);
+					if (dispatcherThreadId == std::thread::id()) {
+						dispatcherThreadId = std::this_thread::get_id();
+					}
+					sameThread &= dispatcherThreadId == std::this_thread::get_id();
+				});
+			}
+		});
+	}
+	for (auto& producer : producers) {
+		producer.join();
+	}
+	std::promise<void> done;
+	dispatcher.post([&]() { done.set_value(); });
+	done.get_future().wait();
+
+	CHECK(sameThread);
+	CHECK_NE(std::this_thread::get_id(), dispatcherThreadId);
+	std::vector<int> expected(taskCount);
+	for (int i = 0; i != taskCount; ++i) {
+		expected[i] = i;
+	}
+	for (const auto& v : received) {
+		CHECK_EQ(expected, v); // FIFO by producer
+	}
+
+	dispatcher.stop();
+	dispatcher.post([]() { FAIL("should not run after stop"); });
+}
@@ -0,0 +1,108 @@
+#include "headercache.h"
+
+#include <doctest.h>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+# include <stdlib.h>
+#endif
+
+using namespace std::literals;
+
+//------------------------------------------------------------------------------
+TEST_CASE("HeaderCache")
+{
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path() / "iplayer-cache-test";
+	std::filesystem::remove_all(tmpDir);
+	std::filesystem::create_directories(tmpDir);
+	const auto cacheFile = tmpDir / "headers.cache";
+	const auto trackFile = tmpDir / "track";
+	std::ofstream(trackFile) << "\"Cached title\" 42\nLa la\n";
+
+	iplayer::TrackHeader track;
+	{
+		iplayer::HeaderCache cache;
+		cache.open(cacheFile);
+		CHECK_FALSE(cache.lookup(trackFile, track));
+		cache.store(iplayer::openTrackHeader(trackFile));
+		CHECK(cache.lookup(trackFile, track));
+		CHECK(cache.save());
+	}
+	{
+		iplayer::HeaderCache cache;
+		cache.open(cacheFile);
+		REQUIRE(cache.lookup(trackFile, track));
+		CHECK_EQ(iplayer::TrackHeader{.filename = trackFile, .title = "Cached title", .duration = 42s},
+		         track);
+
+		std::ofstream(trackFile) << "\"New title\" 4\n"; // different size: stale
+		CHECK_FALSE(cache.lookup(trackFile, track));
+	}
+	{
+		std::ofstream(cacheFile) << "garbage";
+		iplayer::HeaderCache cache;
+		cache.open(cacheFile);
+		CHECK_FALSE(cache.lookup(trackFile, track));
+	}
+	std::filesystem::remove_all(tmpDir);
+}
+
+#ifndef _WIN32 // POSIX paths, environment and permissions
+//------------------------------------------------------------------------------
+TEST_CASE("HeaderCache default file")
+{
+	std::optional<std::string> savedXdg;
+	if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+		savedXdg = xdg;
+	}
+
+	::setenv("XDG_CACHE_HOME", "/var/cache/someone", 1);
+	CHECK_EQ(std::filesystem::path("/var/cache/someone/iplayer/headers.cache"),
+	         iplayer::HeaderCache::defaultFile());
+	::setenv("XDG_CACHE_HOME", "relative", 1); // ignored
+	if (const char* home = std::getenv("HOME"); home && std::filesystem::path(home).is_absolute()) {
+		CHECK_EQ(std::filesystem::path(home) / ".cache/iplayer/headers.cache",
+		         iplayer::HeaderCache::defaultFile());
+	}
+
+	if (savedXdg) {
+		::setenv("XDG_CACHE_HOME", savedXdg->c_str(), 1);
+	} else {
+		::unsetenv("XDG_CACHE_HOME");
+	}
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("HeaderCache save does not follow links")
+{
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path() / "iplayer-cache-test";
+	std::filesystem::remove_all(tmpDir);
+	const auto cacheFile = tmpDir / "new" / "headers.cache";
+	const auto victim = tmpDir / "victim";
+	std::filesystem::create_directories(cacheFile.parent_path());
+	std::ofstream(victim) << "precious";
+	std::filesystem::create_symlink(victim, tmpDir / "new" / "headers.cache.tmp");
+	{
+		iplayer::HeaderCache cache;
+		cache.open(cacheFile);
+		CHECK(cache.save());
+	}
+	std::ostringstream content;
+	content << std::ifstream(victim).rdbuf();
+	CHECK_EQ("precious", content.str());
+	CHECK(std::filesystem::is_regular_file(std::filesystem::symlink_status(cacheFile)));
+
+	const auto createdFile = tmpDir / "created" / "headers.cache";
+	{
+		iplayer::HeaderCache cache;
+		cache.open(createdFile);
+		CHECK(cache.save());
+	}
+	CHECK(std::filesystem::exists(createdFile));
+	CHECK_EQ(std::filesystem::perms::owner_all,
+	         std::filesystem::status(createdFile.parent_path()).permissions());
+
+	std::filesystem::remove_all(tmpDir);
+}
+#endif
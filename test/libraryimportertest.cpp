@@ -0,0 +1,26 @@
+#include "libraryimporter.h"
+
+#include "testutils.h"
+
+#include <doctest.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("importDirectory")
+{
+	// working dir is at solution/$buildsystem/
+	const std::filesystem::path dataDir = "../../data";
+	auto mock = std::make_shared<MockMusicPlayer>();
+	iplayer::Player player{mock, buildPlaylist({0})};
+
+	const auto summary = iplayer::importDirectory(player, dataDir, {.threadCount = 2, .batchSize = 2});
+
+	CHECK_EQ(4, summary.importedCount);
+	const iplayer::TrackHeaderError empty{iplayer::TrackHeaderError::Code::Empty, 0};
+	CHECK_EQ(std::vector<iplayer::InvalidFile>{{dataDir / "invalid1", empty}, {dataDir / "invalid2", empty}},
+	         summary.invalidFiles);
+	REQUIRE_EQ(5, player.getTrackCount());
+	CHECK_EQ(makeTrack(0), *player.getTrack(0));
+	for (std::size_t i = 1; i != 5; ++i) {
+		CHECK_EQ(iplayer::openTrackHeader(dataDir / ("track" + std::to_string(i))), *player.getTrack(i));
+	}
+}
@@ -0,0 +1,107 @@
+#include "librarywatcher.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <doctest.h>
+#include <fstream>
+
+using namespace std::literals;
+
+namespace
+{
+
+/* Collect reported paths, waiting for them with a timeout. */
+struct Reported
+{
+	bool waitFor(const std::filesystem::path& path)
+	{
+		std::unique_lock l(mutex);
+		return cv.wait_for(
+			l, 5s, [&]() { return std::find(paths.begin(), paths.end(), path) != paths.end(); });
+	}
+	void clear()
+	{
+		std::lock_guard l(mutex);
+		paths.clear();
+	}
+	void add(const iplayer::LibraryChanges& changes)
+	{
+		std::lock_guard l(mutex);
+		paths.insert(paths.end(), changes.files.begin(), changes.files.end());
+		for (const auto& directory : changes.removedDirectories) {
+			paths.push_back(directory.string() + " (removed)");
+		}
+		cv.notify_all();
+	}
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::vector<std::filesystem::path> paths;
+};
+
+} // namespace
+
+//------------------------------------------------------------------------------
+TEST_CASE("LibraryWatcher")
+{
+	if (!iplayer::LibraryWatcher::isSupported()) {
+		return;
+	}
+	const std::filesystem::path tmpDir =
+		std::filesystem::absolute(std::filesystem::temp_directory_path() / "iplayer-test-watcher");
+	std::filesystem::remove_all(tmpDir);
+	std::filesystem::create_directories(tmpDir);
+	Reported reported;
+	iplayer::LibraryWatcher watcher([&](auto changes) { reported.add(changes); }, 10ms);
+
+	REQUIRE(watcher.watch(tmpDir));
+	CHECK_FALSE(watcher.watch(tmpDir / "not-exist"));
+
+	std::ofstream(tmpDir / "track") << "\"Title\" 1\n";
+	CHECK(reported.waitFor(tmpDir / "track"));
+
+	std::filesystem::create_directories(tmpDir / "sub");
+	std::ofstream(tmpDir / "sub" / "track") << "\"Title\" 1\n";
+	CHECK(reported.waitFor(tmpDir / "sub" / "track"));
+
+	std::filesystem::rename(tmpDir / "track", tmpDir / "moved");
+	CHECK(reported.waitFor(tmpDir / "moved"));
+
+	reported.clear();
+	std::filesystem::remove(tmpDir / "moved");
+	CHECK(reported.waitFor(tmpDir / "moved"));
+
+	// Moving a directory away removes it, with its sub-directories.
+	std::filesystem::create_directories(tmpDir / "sub" / "subsub");
+	std::ofstream(tmpDir / "sub" / "subsub" / "track") << "\"Title\" 1\n";
+	CHECK(reported.waitFor(tmpDir / "sub" / "subsub" / "track")); // so "subsub" is watched
+	const auto outside = tmpDir.parent_path() / "iplayer-test-watcher-moved";
+	std::filesystem::remove_all(outside);
+	std::filesystem::rename(tmpDir / "sub", outside);
+	CHECK(reported.waitFor((tmpDir / "sub").string() + " (removed)"));
+	CHECK(reported.waitFor((tmpDir / "sub" / "subsub").string() + " (removed)"));
+
+	// Moved back: watched again, and its files reported.
+	std::filesystem::rename(outside, tmpDir / "back");
+	CHECK(reported.waitFor(tmpDir / "back" / "track"));
+	CHECK(reported.waitFor(tmpDir / "back" / "subsub" / "track"));
+	std::ofstream(tmpDir / "back" / "subsub" / "new") << "\"Title\" 1\n";
+	CHECK(reported.waitFor(tmpDir / "back" / "subsub" / "new"));
+
+	reported.clear();
+	std::filesystem::remove_all(tmpDir / "back");
+	CHECK(reported.waitFor((tmpDir / "back").string() + " (removed)"));
+
+	// Directories vanishing or unreadable while listed are skipped.
+	for (int i = 0; i != 20; ++i) {
+		std::filesystem::create_directories(tmpDir / "short" / "lived" / "tree");
+		std::filesystem::remove_all(tmpDir / "short");
+	}
+	std::filesystem::create_directories(tmpDir / "locked" / "sub");
+	std::filesystem::permissions(tmpDir / "locked" / "sub", std::filesystem::perms::none);
+	std::ofstream(tmpDir / "after") << "\"Title\" 1\n";
+	CHECK(reported.waitFor(tmpDir / "after"));
+	std::filesystem::permissions(tmpDir / "locked" / "sub", std::filesystem::perms::owner_all);
+
+	std::filesystem::remove_all(tmpDir);
+}
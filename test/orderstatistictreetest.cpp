@@ -0,0 +1,93 @@
+#include "orderstatistictree.h"
+
+#include <doctest.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+std::vector<int> toVector(const iplayer::OrderStatisticTree<int>& tree)
+{
+	return {tree.begin(), tree.end()};
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+TEST_CASE("OrderStatisticTree::assign")
+{
+	const std::vector v{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+	iplayer::OrderStatisticTree<int> tree;
+
+	tree.assign(v.begin(), v.end());
+	REQUIRE_EQ(v.size(), tree.size());
+	CHECK_EQ(v, toVector(tree));
+	for (std::size_t i = 0; i != v.size(); ++i) {
+		CHECK_EQ(v[i], tree[i]);
+		CHECK_EQ(i, tree.indexOf(tree.iteratorAt(i)));
+	}
+	CHECK_EQ(0, tree.front());
+	CHECK_EQ(9, tree.back());
+	CHECK_EQ(9, *std::prev(tree.end()));
+	CHECK_THROWS(tree.at(10));
+
+	const std::vector inserted{42, 43};
+	auto it = tree.insert(3, inserted.begin(), inserted.end());
+	CHECK_EQ(3, tree.indexOf(it));
+	CHECK_EQ(std::vector{0, 1, 2, 42, 43, 3, 4, 5, 6, 7, 8, 9}, toVector(tree));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("OrderStatisticTree versus vector")
+{
+	std::default_random_engine rng{42};
+	auto rand_below = [&](std::size_t n) {
+		return std::uniform_int_distribution<std::size_t>{0, n - 1}(rng);
+	};
+	iplayer::OrderStatisticTree<int> tree;
+	std::vector<int> expected;
+
+	for (int i = 0; i != 2000; ++i) {
+		switch (rand_below(4)) {
+			case 0:
+			case 1:
+			{
+				const auto pos = rand_below(expected.size() + 1);
+				tree.insert(pos, i);
+				expected.insert(expected.begin() + pos, i);
+				break;
+			}
+			case 2:
+			{
+				if (expected.empty()) break;
+				const auto pos = rand_below(expected.size());
+				tree.erase(pos);
+				expected.erase(expected.begin() + pos);
+				break;
+			}
+			case 3:
+			{
+				if (expected.empty()) break;
+				const auto from = rand_below(expected.size());
+				const auto to = rand_below(expected.size());
+				tree.move(from, to);
+				const int value = expected[from];
+				expected.erase(expected.begin() + from);
+				expected.insert(expected.begin() + to, value);
+				break;
+			}
+		}
+		REQUIRE_EQ(expected.size(), tree.size());
+	}
+	CHECK_EQ(expected, toVector(tree));
+	for (std::size_t i = 0; i != expected.size(); ++i) {
+		CHECK_EQ(i, tree.indexOf(tree.iteratorAt(i)));
+	}
+
+	const auto copy = tree;
+	CHECK_EQ(expected, toVector(copy));
+	CHECK_EQ(expected, tree.extract());
+	CHECK(tree.empty());
+}
@@ -0,0 +1,135 @@
+#include "outputmultiplexer.h"
+
+#include <algorithm>
+#include <doctest.h>
+#include <future>
+#include <set>
+#include <sstream>
+
+namespace
+{
+
+/* Sink blocked until released. */
+class BlockingBuffer : public std::stringbuf
+{
+public:
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+
+protected:
+	std::streamsize xsputn(const char* s, std::streamsize n) override
+	{
+		released.wait();
+		return std::stringbuf::xsputn(s, n);
+	}
+};
+
+} // namespace
+
+//------------------------------------------------------------------------------
+TEST_CASE("OutputMultiplexer lines are not interleaved")
+{
+	constexpr int producerCount = 4;
+	constexpr int lineCount = 2000;
+	std::ostringstream sink;
+	{
+		iplayer::OutputMultiplexer output(sink, 256);
+		std::vector<std::thread> producers;
+		for (int p = 0; p != producerCount; ++p) {
+			producers.emplace_back([&, p, os = output.createStream(
+			                                  iplayer::OutputMultiplexer::OverflowPolicy::Block)]() {
+				for (int i = 0; i != lineCount; ++i) {
+					*os << "producer " << p << " line " << i << std::string(i % 50, '.') << "\n";
+				}
+				*os << "partial " << p << std::flush;
+				*os << " end\n";
+			});
+		}
+		for (auto& producer : producers) {
+			producer.join();
+		}
+		CHECK_EQ(0, output.getDroppedCount());
+	}
+	std::istringstream is(sink.str());
+	std::vector<int> nextLine(producerCount);
+	std::string line;
+	std::set<std::string> partials;
+	while (std::getline(is, line)) {
+		int p;
+		int i;
+		if (line.starts_with("partial ")) {
+			partials.insert(line);
+			continue;
+		}
+		REQUIRE_EQ(2, std::sscanf(line.c_str(), "producer %d line %d", &p, &i));
+		REQUIRE_EQ(nextLine[p], i);
+		REQUIRE_EQ("producer " + std::to_string(p) + " line " + std::to_string(i)
+		               + std::string(i % 50, '.'),
+		           line);
+		++nextLine[p];
+	}
+	CHECK_EQ(std::vector<int>(producerCount, lineCount), nextLine);
+	CHECK_EQ(producerCount, partials.size());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("OutputMultiplexer lines longer than the ring")
+{
+	std::ostringstream sink;
+	const std::string line(5000, 'x');
+	{
+		iplayer::OutputMultiplexer output(sink, 1024);
+		const auto os = output.createStream(iplayer::OutputMultiplexer::OverflowPolicy::Block);
+		*os << line << "\n" << std::flush;
+		*os << line << std::flush; // also without newline
+	}
+	CHECK_EQ(line + "\n" + line, sink.str());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("OutputMultiplexer drops when the sink falls behind")
+{
+	BlockingBuffer buffer;
+	std::ostream sink(&buffer);
+	iplayer::OutputMultiplexer output(sink, 64);
+	const auto os = output.createStream(iplayer::OutputMultiplexer::OverflowPolicy::Drop);
+
+	for (int i = 0; i != 100; ++i) {
+		*os << "line " << i << "\n"; // never blocks
+	}
+	CHECK_LT(0, output.getDroppedCount());
+	buffer.release.set_value();
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("OutputMultiplexer drops whole lines")
+{
+	std::ostringstream sink;
+	{
+		iplayer::OutputMultiplexer output(sink, 64);
+		const auto os = output.createStream(iplayer::OutputMultiplexer::OverflowPolicy::Drop);
+		*os << "first\n" << std::string(100, 'x') << "\nlast\n" << std::flush; // one write
+		*os << std::string(100, 'y') << std::flush; // without newline
+		CHECK_EQ(2, output.getDroppedCount());
+	}
+	CHECK_EQ("first\nlast\n", sink.str());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("OutputMultiplexer releases the rings of destroyed streams")
+{
+	std::ostringstream sink;
+	{
+		iplayer::OutputMultiplexer output(sink, 64);
+		for (int i = 0; i != 1000; ++i) {
+			const auto os = output.createStream(iplayer::OutputMultiplexer::OverflowPolicy::Block);
+			*os << "line\n";
+		}
+		{
+			const auto os = output.createStream(iplayer::OutputMultiplexer::OverflowPolicy::Drop);
+			*os << std::string(100, 'x') << "\n";
+		}
+		CHECK_EQ(1, output.getDroppedCount()); // still counted
+	}
+	CHECK_EQ(1000, std::ranges::count(sink.str(), '\n'));
+}
@@ -0,0 +1,35 @@
+#include "playbackclock.h"
+
+#include <doctest.h>
+
+using namespace std::literals;
+
+//------------------------------------------------------------------------------
+TEST_CASE("PlaybackClock")
+{
+	const iplayer::PlaybackClock::Clock::time_point t0{};
+	iplayer::PlaybackClock clock;
+
+	CHECK_FALSE(clock.isRunning());
+	CHECK_EQ(0ns, clock.getPosition(t0 + 5s));
+
+	const auto version = clock.getVersion();
+	clock.start(t0);
+	CHECK_NE(version, clock.getVersion());
+	CHECK(clock.isRunning());
+	CHECK_EQ(1500ms, clock.getPosition(t0 + 1500ms));
+	CHECK(t0 + 3s == clock.timeAt(3s));
+
+	clock.pause(t0 + 2s);
+	CHECK_EQ(2s, clock.getPosition(t0 + 10s));
+
+	clock.start(t0 + 10s);
+	CHECK_EQ(2s + 250ms, clock.getPosition(t0 + 10s + 250ms));
+
+	clock.seek(42ms, t0 + 20s);
+	CHECK_EQ(42ms + 1s, clock.getPosition(t0 + 21s));
+
+	// No drift: the position is computed, not accumulated.
+	CHECK_EQ(42ms + 10h, clock.getPosition(t0 + 20s + 10h));
+	CHECK(t0 + 20s + 10h == clock.timeAt(42ms + 10h));
+}
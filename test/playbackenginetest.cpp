@@ -0,0 +1,162 @@
+#include "playbackengine.h"
+#include "virtualmusicplayer.h"
+
+#include <algorithm>
+#include <doctest.h>
+#include <fstream>
+#include <future>
+#include <sstream>
+
+using namespace std::literals;
+
+namespace
+{
+
+struct CountingTimer : iplayer::PlaybackEngine::Timer
+{
+	void onTimer() override
+	{
+		firedAt = iplayer::PlaybackEngine::Clock::now();
+		fired.set_value();
+	}
+
+	iplayer::PlaybackEngine::Clock::time_point firedAt;
+	std::promise<void> fired;
+};
+
+} // namespace
+
+//------------------------------------------------------------------------------
+TEST_CASE("PlaybackEngine timers")
+{
+	iplayer::PlaybackEngine engine(2);
+	const auto t0 = iplayer::PlaybackEngine::Clock::now();
+
+	// Spread over several levels of the wheel.
+	std::vector<std::unique_ptr<CountingTimer>> timers;
+	const std::vector<std::chrono::milliseconds> delays{0ms, 3ms, 70ms, 150ms, 300ms};
+	for (auto delay : delays) {
+		timers.push_back(std::make_unique<CountingTimer>());
+		engine.schedule(*timers.back(), t0 + delay);
+	}
+	CountingTimer cancelled;
+	engine.schedule(cancelled, t0 + 50ms);
+	engine.cancel(cancelled);
+
+	for (std::size_t i = 0; i != timers.size(); ++i) {
+		REQUIRE(timers[i]->fired.get_future().wait_for(5s) == std::future_status::ready);
+		CHECK(timers[i]->firedAt >= t0 + delays[i]);
+	}
+	CHECK(cancelled.fired.get_future().wait_for(100ms) == std::future_status::timeout);
+	for (auto& timer : timers) {
+		engine.cancelAndWait(*timer); // before destroying it
+	}
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("VirtualMusicPlayer many players")
+{
+	const std::filesystem::path track = "../../data/track1";
+	constexpr std::size_t playerCount = 1000;
+	iplayer::PlaybackEngine engine(2);
+
+	std::vector<std::ostringstream> outputs(playerCount);
+	std::vector<std::unique_ptr<iplayer::VirtualMusicPlayer>> players;
+	std::atomic<std::size_t> finishedCount = 0;
+	std::promise<void> allFinished;
+	for (auto& os : outputs) {
+		players.push_back(std::make_unique<iplayer::VirtualMusicPlayer>(engine, os, 5ms));
+		players.back()->setOnMusicFinished([&]() {
+			if (++finishedCount == playerCount) {
+				allFinished.set_value();
+			}
+		});
+		REQUIRE(players.back()->openMusic(track));
+	}
+	for (auto& player : players) {
+		player->play();
+	}
+	REQUIRE(allFinished.get_future().wait_for(10s) == std::future_status::ready);
+
+	std::ifstream file(track);
+	std::string expected;
+	std::getline(file, expected); // header
+	expected = std::string(std::istreambuf_iterator<char>(file), {});
+	if (!expected.ends_with('\n')) {
+		expected += '\n';
+	}
+	for (const auto& os : outputs) {
+		REQUIRE_EQ(expected, os.str());
+	}
+	CHECK_EQ(0ms, players.front()->getPosition());
+	CHECK_LT(sizeof(iplayer::VirtualMusicPlayer), 512);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("VirtualMusicPlayer pause and seek")
+{
+	iplayer::PlaybackEngine engine(0); // simulated time
+	const auto t0 = engine.now();
+	std::ostringstream os;
+	iplayer::VirtualMusicPlayer player(engine, os, 20ms);
+	REQUIRE(player.openMusic("../../data/track2"));
+
+	player.seek(60ms); // line 3 is next, output at 80ms
+	player.play();
+	engine.runUntil(t0 + 19ms);
+	CHECK(os.str().empty());
+	engine.runUntil(t0 + 20ms);
+	CHECK(os.str().starts_with("une chanson monotone"));
+	CHECK_EQ(1, std::ranges::count(os.str(), '\n'));
+
+	player.pause();
+	CHECK_EQ(80ms, player.getPosition());
+	engine.runUntil(t0 + 1s);
+	CHECK_EQ(1, std::ranges::count(os.str(), '\n'));
+	CHECK_EQ(80ms, player.getPosition());
+
+	os.str("");
+	player.seek(0ms);
+	player.play();
+	engine.runUntil(t0 + 1s + 40ms); // lines 0 and 1
+	CHECK(os.str().starts_with("Mais non"));
+	CHECK_EQ(2, std::ranges::count(os.str(), '\n'));
+	CHECK_EQ(40ms, player.getPosition());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("PlaybackEngine timer re-armed while running")
+{
+	struct SelfArmingTimer : iplayer::PlaybackEngine::Timer
+	{
+		explicit SelfArmingTimer(iplayer::PlaybackEngine& engine) : engine(engine) {}
+
+		void onTimer() override
+		{
+			const auto active = ++activeCount;
+			maxActiveCount = std::max(maxActiveCount.load(), active);
+			if (++runCount < 50) {
+				engine.schedule(*this, engine.now()); // due again, before the end of this run
+				std::this_thread::sleep_for(1ms);
+			} else {
+				done.set_value();
+			}
+			--activeCount;
+		}
+
+		iplayer::PlaybackEngine& engine;
+		std::atomic<int> activeCount = 0;
+		std::atomic<int> maxActiveCount = 0;
+		std::atomic<int> runCount = 0;
+		std::promise<void> done;
+	};
+
+	iplayer::PlaybackEngine engine(4);
+	SelfArmingTimer timer(engine);
+	engine.schedule(timer, engine.now());
+	REQUIRE(timer.done.get_future().wait_for(10s) == std::future_status::ready);
+	engine.cancelAndWait(timer);
+	CHECK_EQ(0, timer.activeCount);
+	CHECK_EQ(1, timer.maxActiveCount);
+	CHECK_EQ(50, timer.runCount);
+}
@@ -3,32 +3,12 @@
 #include "testutils.h"
 
 #include <doctest.h>
+#include <fstream>
+#include <numeric>
+#include <set>
 
 using namespace std::literals;
 
-struct MockMusicPlayer : iplayer::IMusicPlayer
-{
-	bool openMusic(const std::filesystem::path& path) override
-	{
-		this->path = path;
-		return true;
-	}
-	void pause() override { inPause = true; }
-	void play() override
-	{
-		inPause = false;
-		elapsedTime = 1s;
-	}
-	void setElapsedTime(const std::chrono::seconds& s) override { elapsedTime = s; }
-	std::chrono::seconds getElapsedTime() override { return elapsedTime; }
-	void setOnMusicFinished(std::function<void()> f) { onMusicFinished = f; }
-
-	std::function<void()> onMusicFinished;
-	std::filesystem::path path;
-	std::chrono::seconds elapsedTime = 0s;
-	bool inPause = true;
-};
-
 //------------------------------------------------------------------------------
 TEST_CASE("Next")
 {
@@ -106,6 +86,24 @@ TEST_CASE("Random")
 	CHECK_EQ(paths[0], mock->path);
 }
 
+//------------------------------------------------------------------------------
+TEST_CASE("Random previous without selection")
+{
+	auto mock = std::make_shared<MockMusicPlayer>();
+	std::vector<std::size_t> numbers(100);
+	std::iota(numbers.begin(), numbers.end(), 0);
+	iplayer::Player player{mock, buildPlaylist(numbers)};
+
+	player.setRandomMode(true);
+	player.previous(); // starts the permutation, as next() would
+	std::set<std::filesystem::path> paths{mock->path};
+	for (std::size_t i = 1; i != numbers.size(); ++i) {
+		player.next();
+		paths.insert(mock->path);
+	}
+	CHECK_EQ(numbers.size(), paths.size()); // no repeat
+}
+
 //------------------------------------------------------------------------------
 TEST_CASE("Playlist::insertAt")
 {
@@ -160,3 +158,153 @@ TEST_CASE("Playlist::move")
 
 
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Player::applyBatch")
+{
+	auto mock = std::make_shared<MockMusicPlayer>();
+	iplayer::Player player{mock, buildPlaylist({0, 1, 2, 3})};
+
+	player.select(2);
+	REQUIRE_EQ(makeTrack(2).filename, mock->path);
+
+	std::vector<iplayer::PlaylistEdit> edits;
+	edits.emplace_back(iplayer::edit::Insert{0, makeTrack(4)}); // 4, 0, 1, 2, 3
+	edits.emplace_back(iplayer::edit::Remove{2});               // 4, 0, 2, 3
+	edits.emplace_back(iplayer::edit::Move{2, 0});              // 2, 4, 0, 3
+	edits.emplace_back(iplayer::edit::Append{makeTrack(5)});    // 2, 4, 0, 3, 5
+	player.applyBatch(std::move(edits));
+
+	REQUIRE_EQ(5, player.getTrackCount());
+	CHECK_EQ(std::optional<std::size_t>(0), player.getSelectionIndex());
+	player.next();
+	CHECK_EQ(makeTrack(4).filename, mock->path);
+
+	edits.clear();
+	edits.emplace_back(iplayer::edit::Remove{1}); // selected: fallback to previous
+	edits.emplace_back(iplayer::edit::Remove{42}); // out of range: ignored
+	player.applyBatch(std::move(edits));
+	CHECK_EQ(std::optional<std::size_t>(0), player.getSelectionIndex());
+	CHECK_EQ(4, player.getTrackCount());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Player::getSnapshot")
+{
+	auto mock = std::make_shared<MockMusicPlayer>();
+	iplayer::Player player{mock, buildPlaylist({0, 1, 2})};
+
+	const auto before = player.getSnapshot();
+	player.remove(0);
+	player.push_back(makeTrack(3));
+	const auto after = player.getSnapshot();
+
+	REQUIRE_EQ(3, before->size());
+	CHECK_EQ(makeTrack(0), *(*before)[0]);
+	REQUIRE_EQ(3, after->size());
+	CHECK_EQ(makeTrack(1), *(*after)[0]);
+	CHECK_EQ(makeTrack(3), *(*after)[2]);
+	CHECK_EQ(makeTrack(3), *player.getTrack(2));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Player::insertRange")
+{
+	auto mock = std::make_shared<MockMusicPlayer>();
+	iplayer::Player player{mock, buildPlaylist({0, 3})};
+
+	player.select(1);
+	std::vector<iplayer::TrackHeader> tracks{makeTrack(1), makeTrack(2)};
+	player.insertRange(1, tracks);
+	tracks = {makeTrack(4)};
+	player.append(tracks);
+
+	REQUIRE_EQ(5, player.getTrackCount());
+	CHECK_EQ(std::optional<std::size_t>(3), player.getSelectionIndex());
+	for (std::size_t i = 0; i != 5; ++i) {
+		CHECK_EQ(makeTrack(i), *player.getTrack(i));
+	}
+	player.previous();
+	CHECK_EQ(makeTrack(2).filename, mock->path);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Player::refreshTracks")
+{
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path() / "iplayer-test-refresh";
+	std::filesystem::create_directories(tmpDir);
+	std::vector<iplayer::TrackHeader> tracks;
+	for (std::size_t i = 0; i != 3; ++i) {
+		tracks.push_back(makeTrack(i));
+		tracks.back().filename = tmpDir / ("track" + std::to_string(i));
+		std::ofstream(tracks.back().filename.path()) << std::quoted(tracks.back().title) << " " << i << "\n";
+	}
+	auto mock = std::make_shared<MockMusicPlayer>();
+	iplayer::Player player{mock, iplayer::Playlist{}};
+	player.append(tracks);
+
+	std::filesystem::remove(tmpDir / "track1");
+	std::ofstream(tmpDir / "track2") << "\"New title\" 42\n";
+	const std::vector<std::filesystem::path> changed{tmpDir / "track1", tmpDir / "track2"};
+	player.refreshTracks(changed);
+
+	CHECK_EQ("Title0", player.getTrack(0)->title);
+	CHECK_FALSE(player.isPlayable(*player.getTrack(1)));
+	CHECK_EQ("New title", player.getTrack(2)->title);
+	CHECK_EQ(42s, player.getTrack(2)->duration);
+
+	player.next();
+	player.next(); // skip track1 without opening it
+	CHECK_EQ(tmpDir / "track2", mock->path);
+	CHECK_EQ(2, mock->openCount);
+
+	std::ofstream(tmpDir / "track1") << "\"Back\" 1\n";
+	player.refreshTracks(std::span(changed).first(1));
+	CHECK(player.isPlayable(*player.getTrack(1)));
+	player.previous();
+	CHECK_EQ(tmpDir / "track1", mock->path);
+
+	// Index follows edits: duplicates are all refreshed, removed tracks are not.
+	auto duplicate = tracks[2];
+	duplicate.title = "Duplicate";
+	player.push_back(std::move(duplicate));
+	player.remove(2);
+	std::ofstream(tmpDir / "track2") << "\"Newer title\" 43\n";
+	player.refreshTracks(std::span(changed).last(1));
+	REQUIRE_EQ(3, player.getTrackCount());
+	CHECK_EQ("Newer title", player.getTrack(2)->title);
+	CHECK_EQ(43s, player.getTrack(2)->duration);
+
+	const std::vector<std::filesystem::path> removed{tmpDir};
+	player.markRemovedDirectories(removed);
+	CHECK_FALSE(player.isPlayable(*player.getTrack(0)));
+	CHECK_FALSE(player.isPlayable(*player.getTrack(2)));
+	player.refreshAllTracks(); // files are still there
+	CHECK(player.isPlayable(*player.getTrack(0)));
+	CHECK(player.isPlayable(*player.getTrack(2)));
+
+	std::filesystem::remove_all(tmpDir);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Player prefetches next track")
+{
+	auto mock = std::make_shared<MockMusicPlayer>();
+	iplayer::Player player{mock, buildPlaylist({0, 1, 2})};
+
+	player.next();
+	CHECK_EQ(makeTrack(1).filename, mock->prefetchedPath);
+	player.select(2);
+	CHECK_EQ(makeTrack(1).filename, mock->prefetchedPath); // nothing after the last one
+	player.setRepeatMode(true);
+	player.previous();
+	CHECK_EQ(makeTrack(2).filename, mock->prefetchedPath);
+	player.next();
+	CHECK_EQ(makeTrack(0).filename, mock->prefetchedPath);
+
+	player.setRandomMode(true);
+	player.next();
+	const auto expected = mock->prefetchedPath;
+	player.next();
+	CHECK_EQ(expected, mock->path);
+}
@@ -0,0 +1,87 @@
+#include "playlistsnapshot.h"
+
+#include "testutils.h"
+
+#include <doctest.h>
+#include <random>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+std::vector<int> getOrder(const iplayer::PlaylistSnapshot& snapshot)
+{
+	std::vector<int> res;
+	snapshot.forEach([&](const iplayer::TrackRef& track) {
+		res.push_back(static_cast<int>(track->duration.count()));
+	});
+	return res;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+TEST_CASE("PlaylistSnapshot versions are independent")
+{
+	iplayer::TrackStore store;
+	const iplayer::PlaylistSnapshot v0;
+	const auto v1 = v0.insert(0, store.intern(makeTrack(1)));
+	const auto v2 = v1.insert(0, store.intern(makeTrack(0))).insert(5, store.intern(makeTrack(2)));
+	const auto v3 = v2.move(0, 2).erase(0);
+
+	CHECK_EQ(std::vector<int>{}, getOrder(v0));
+	CHECK_EQ(std::vector{1}, getOrder(v1));
+	CHECK_EQ(std::vector{0, 1, 2}, getOrder(v2));
+	CHECK_EQ(std::vector{2, 0}, getOrder(v3));
+	CHECK_THROWS(v3.at(2));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("PlaylistSnapshot versus vector")
+{
+	iplayer::TrackStore store;
+	std::default_random_engine rng{42};
+	auto rand_below = [&](std::size_t n) {
+		return std::uniform_int_distribution<std::size_t>{0, n - 1}(rng);
+	};
+	iplayer::PlaylistSnapshot snapshot;
+	std::vector<int> expected;
+
+	for (int i = 0; i != 3000; ++i) {
+		if (expected.empty() || rand_below(3) != 0) {
+			const auto pos = rand_below(expected.size() + 1);
+			snapshot = snapshot.insert(pos, store.intern(makeTrack(i)));
+			expected.insert(expected.begin() + pos, i);
+		} else {
+			const auto pos = rand_below(expected.size());
+			snapshot = snapshot.erase(pos);
+			expected.erase(expected.begin() + pos);
+		}
+	}
+	CHECK_EQ(expected, getOrder(snapshot));
+	REQUIRE_EQ(expected.size(), snapshot.size());
+	for (std::size_t i = 0; i != expected.size(); ++i) {
+		CHECK_EQ(expected[i], snapshot[i]->duration.count());
+	}
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("PlaylistSnapshot chunks stay filled")
+{
+	iplayer::TrackStore store;
+	std::default_random_engine rng{42};
+	const auto track = store.intern(makeTrack(0));
+	iplayer::PlaylistSnapshot snapshot;
+
+	for (int i = 0; i != 20'000; ++i) {
+		snapshot = snapshot.insert(snapshot.size(), track);
+	}
+	CHECK_EQ(20'000, snapshot.size());
+	CHECK_LE(snapshot.getChunkCount(), 20'000 / 256 + 1);
+
+	while (1000 < snapshot.size()) {
+		const auto pos = std::uniform_int_distribution<std::size_t>{0, snapshot.size() - 1}(rng);
+		snapshot = snapshot.erase(pos);
+	}
+	CHECK_LE(snapshot.getChunkCount(), 1000 / 128 + 1);
+}
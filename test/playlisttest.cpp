@@ -2,6 +2,7 @@
 
 #include "testutils.h"
 
+#include <algorithm>
 #include <doctest.h>
 
 namespace
@@ -14,7 +15,7 @@ std::vector<int> getOrder(const iplayer::Playlist& p)
 
 	std::transform(
 		p.getTracks().begin(), p.getTracks().end(), res.begin(), [](const auto& p) -> int {
-			return static_cast<int>(p.second.duration.count());
+			return static_cast<int>(p.second->duration.count());
 		});
 	return res;
 }
@@ -80,6 +81,22 @@ TEST_CASE("removeDuplicate")
 	CHECK_EQ(std::vector{0, 1, 2, 3, 4}, getOrder(playlist));
 }
 
+//------------------------------------------------------------------------------
+TEST_CASE("removeDuplicate parallel")
+{
+	std::vector<std::size_t> v;
+	for (std::size_t i = 0; i != 100'000; ++i) {
+		v.push_back((i * 7919) % 30'011);
+	}
+	auto sequential = buildPlaylist(v);
+	auto parallel = buildPlaylist(v);
+
+	sequential.removeDuplicate(iplayer::Execution::Sequential);
+	parallel.removeDuplicate(iplayer::Execution::Parallel);
+	REQUIRE_EQ(30'011, sequential.getTracks().size());
+	CHECK_EQ(getOrder(sequential), getOrder(parallel));
+}
+
 //------------------------------------------------------------------------------
 TEST_CASE("info")
 {
@@ -95,3 +112,65 @@ TEST_CASE("info")
 
 	CHECK_EQ(expected, ss.str());
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("positionOf")
+{
+	auto playlist = buildPlaylist({0, 1, 2, 3, 4});
+	const auto id0 = playlist.getTracks()[0].first;
+	const auto id3 = playlist.getTracks()[3].first;
+
+	CHECK_EQ(std::optional<std::size_t>(0), playlist.positionOf(id0));
+	CHECK_EQ(std::optional<std::size_t>(3), playlist.positionOf(id3));
+
+	playlist.move(0, 4);
+	CHECK_EQ(std::optional<std::size_t>(4), playlist.positionOf(id0));
+	CHECK_EQ(std::optional<std::size_t>(2), playlist.positionOf(id3));
+
+	playlist.remove(4);
+	CHECK_EQ(std::nullopt, playlist.positionOf(id0));
+
+	const auto copy = playlist;
+	CHECK_EQ(std::optional<std::size_t>(2), copy.positionOf(id3));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("shuffleLazily")
+{
+	const std::vector<int> expected{0, 1, 2, 3, 4, 5, 6, 7};
+	auto playlist = buildPlaylist({0, 1, 2, 3, 4, 5, 6, 7});
+
+	playlist.shuffleLazily(1);
+	CHECK_EQ(0, getOrder(playlist)[0]); // kept as drawn
+
+	playlist.draw(3);
+	const auto prefix = getOrder(playlist);
+	playlist.draw(7);
+	auto order = getOrder(playlist);
+	CHECK(std::equal(prefix.begin(), prefix.begin() + 4, order.begin()));
+
+	std::sort(order.begin(), order.end());
+	CHECK_EQ(expected, order);
+	for (std::size_t i = 0; i != playlist.getTracks().size(); ++i) {
+		CHECK_EQ(std::optional(i), playlist.positionOf(playlist.getTracks()[i].first));
+	}
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("append and insertRange")
+{
+	auto playlist = buildPlaylist({0, 4});
+	std::vector<iplayer::TrackHeader> tracks{makeTrack(5), makeTrack(6)};
+
+	playlist.append(tracks);
+	CHECK_EQ(std::vector{0, 4, 5, 6}, getOrder(playlist));
+
+	const std::vector<iplayer::TrackRef> refs{iplayer::TrackStore::global().intern(makeTrack(1)),
+	                                          iplayer::TrackStore::global().intern(makeTrack(2)),
+	                                          iplayer::TrackStore::global().intern(makeTrack(3))};
+	playlist.insertRange(1, refs);
+	CHECK_EQ(std::vector{0, 1, 2, 3, 4, 5, 6}, getOrder(playlist));
+	for (std::size_t i = 0; i != playlist.getTracks().size(); ++i) {
+		CHECK_EQ(std::optional(i), playlist.positionOf(playlist.getTracks()[i].first));
+	}
+}
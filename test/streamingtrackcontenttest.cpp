@@ -0,0 +1,97 @@
+#include "streamingtrackcontent.h"
+
+#include <doctest.h>
+#include <random>
+#include <thread>
+
+//------------------------------------------------------------------------------
+TEST_CASE("StreamingTrackContent")
+{
+	const std::filesystem::path file = std::filesystem::temp_directory_path() / "iplayer-test-streaming";
+	const std::size_t lineCount = 1000;
+	{
+		std::ofstream os(file);
+		os << "\"Long\" 1000\n";
+		for (std::size_t i = 0; i != lineCount; ++i) {
+			os << "Line " << i << std::string(i % 7, '.') << "\n";
+		}
+	}
+	auto expectedLine = [](std::size_t i) {
+		return "Line " + std::to_string(i) + std::string(i % 7, '.');
+	};
+	std::ifstream is(file);
+	std::string header;
+	std::getline(is, header);
+	iplayer::StreamingTrackContent content(std::move(is), {.readAhead = 8, .checkpointInterval = 64});
+
+	for (std::size_t i = 0; i != lineCount; ++i) {
+		REQUIRE_EQ(expectedLine(i), content.getLine(i));
+	}
+	CHECK_FALSE(content.getLine(lineCount));
+	CHECK_EQ(lineCount / 64 + 1, content.getCheckpointCount());
+
+	std::default_random_engine rng{42};
+	for (int i = 0; i != 100; ++i) {
+		const auto n = std::uniform_int_distribution<std::size_t>{0, lineCount - 1}(rng);
+		REQUIRE_EQ(expectedLine(n), content.getLine(n));
+	}
+	CHECK_FALSE(content.getLine(lineCount + 10));
+	CHECK_EQ("Line 0", content.getLine(0));
+
+	std::filesystem::remove(file);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("StreamingTrackContent forward seek")
+{
+	const std::filesystem::path file = std::filesystem::temp_directory_path() / "iplayer-test-streaming";
+	{
+		std::ofstream os(file);
+		os << "\"Short\" 3\nA\nB\nC\n";
+	}
+	auto content = iplayer::openTrackContent(file, iplayer::TrackLoading::Streaming);
+	REQUIRE(content);
+
+	CHECK_EQ("C", content->getLine(2)); // before the end is known
+	CHECK_EQ("A", content->getLine(0));
+	CHECK_FALSE(content->getLine(3));
+	content.reset();
+
+	std::filesystem::remove(file);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("StreamingTrackContent contents read together")
+{
+	const std::filesystem::path file = std::filesystem::temp_directory_path() / "iplayer-test-streaming";
+	const std::size_t lineCount = 200;
+	{
+		std::ofstream os(file);
+		for (std::size_t i = 0; i != lineCount; ++i) {
+			os << i << "\n";
+		}
+	}
+	std::vector<std::unique_ptr<iplayer::StreamingTrackContent>> contents;
+	for (int i = 0; i != 4; ++i) {
+		contents.push_back(std::make_unique<iplayer::StreamingTrackContent>(
+			std::ifstream(file), iplayer::StreamingOptions{.readAhead = 4}));
+	}
+
+	std::vector<std::thread> readers;
+	for (auto& content : contents) {
+		readers.emplace_back([&content, lineCount]() {
+			for (std::size_t i = 0; i != lineCount; ++i) {
+				REQUIRE_EQ(std::to_string(i), content->getLine(i));
+			}
+			CHECK_FALSE(content->getLine(lineCount));
+		});
+	}
+	for (auto& reader : readers) {
+		reader.join();
+	}
+	contents.pop_back();
+	CHECK_EQ("10", contents[0]->getLine(10));
+	contents.clear();
+
+	std::filesystem::remove(file);
+}
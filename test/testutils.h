@@ -1,5 +1,6 @@
 #pragma once
 
+#include "imusicplayer.h"
 #include "playlist.h"
 #include "trackheader.h"
 
@@ -22,3 +23,31 @@ inline iplayer::Playlist buildPlaylist(const std::vector<std::size_t>& v)
 	}
 	return res;
 }
+
+//------------------------------------------------------------------------------
+struct MockMusicPlayer : iplayer::IMusicPlayer
+{
+	bool openMusic(const std::filesystem::path& path) override
+	{
+		this->path = path;
+		++openCount;
+		return true;
+	}
+	void pause() override { inPause = true; }
+	void play() override
+	{
+		inPause = false;
+		elapsedTime = std::chrono::seconds(1);
+	}
+	void setElapsedTime(const std::chrono::seconds& s) override { elapsedTime = s; }
+	std::chrono::seconds getElapsedTime() override { return elapsedTime; }
+	void setOnMusicFinished(std::function<void()> f) { onMusicFinished = f; }
+	void prefetch(const std::filesystem::path& path) override { prefetchedPath = path; }
+
+	std::function<void()> onMusicFinished;
+	std::filesystem::path path;
+	std::size_t openCount = 0;
+	std::filesystem::path prefetchedPath;
+	std::chrono::seconds elapsedTime{};
+	bool inPause = true;
+};
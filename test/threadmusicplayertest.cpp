@@ -0,0 +1,156 @@
+#include "threadmusicplayer.h"
+
+#include <condition_variable>
+#include <doctest.h>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/* Lines written to the stream, with the time each one was ended. */
+class TimedLines : public std::streambuf
+{
+public:
+	struct Line
+	{
+		std::string text;
+		Clock::time_point time;
+	};
+
+	// Lines once `count` are written, or all of them after `timeout`.
+	std::vector<Line> waitFor(std::size_t count, std::chrono::milliseconds timeout = 5s)
+	{
+		std::unique_lock l(mutex);
+		cv.wait_for(l, timeout, [&]() { return lines.size() >= count; });
+		return lines;
+	}
+
+	// Time at which `text` is written, or nullopt if not written within `timeout`.
+	std::optional<Clock::time_point> waitForLine(const std::string& text,
+	                                             std::chrono::milliseconds timeout = 5s)
+	{
+		std::unique_lock l(mutex);
+		std::optional<Clock::time_point> res;
+		cv.wait_for(l, timeout, [&]() {
+			for (const auto& line : lines) {
+				if (line.text == text) {
+					res = line.time;
+				}
+			}
+			return res.has_value();
+		});
+		return res;
+	}
+
+protected:
+	int_type overflow(int_type c) override
+	{
+		std::lock_guard l(mutex);
+		if (c == '\n') {
+			lines.push_back({std::move(current), Clock::now()});
+			current.clear();
+			cv.notify_all();
+		} else if (c != traits_type::eof()) {
+			current += traits_type::to_char_type(c);
+		}
+		return c;
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::vector<Line> lines;
+	std::string current;
+};
+
+//------------------------------------------------------------------------------
+std::filesystem::path writeTrack(std::size_t lineCount)
+{
+	const auto file = std::filesystem::temp_directory_path() / "iplayer-test-ticks";
+	std::ofstream os(file);
+	os << "\"Ticks\" " << lineCount << "\n";
+	for (std::size_t i = 0; i != lineCount; ++i) {
+		os << "Line " << i << "\n";
+	}
+	return file;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+TEST_CASE("ThreadMusicPlayer lines on their deadlines")
+{
+	constexpr auto period = 100ms;
+	const auto file = writeTrack(100);
+	TimedLines lines;
+	std::ostream os(&lines);
+	{
+		iplayer::ThreadMusicPlayer player(os, iplayer::TrackLoading::Full, period);
+		REQUIRE(player.openMusic(file));
+
+		const auto t0 = Clock::now();
+		player.play();
+		const auto output = lines.waitFor(8);
+		REQUIRE_LE(8, output.size());
+		// Every line, in order, never before its deadline (no upper bound: a loaded machine may
+		// wake up late, but a late tick is caught up as deadlines come from the clock).
+		for (std::size_t i = 0; i != 8; ++i) {
+			CHECK_EQ("Line " + std::to_string(i), output[i].text);
+			CHECK_GE(output[i].time, t0 + (i + 1) * period);
+		}
+	}
+	std::filesystem::remove(file);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("ThreadMusicPlayer pause, play and seek wake-ups")
+{
+	constexpr auto period = 100ms;
+	const auto file = writeTrack(100);
+	TimedLines lines;
+	std::ostream os(&lines);
+	{
+		iplayer::ThreadMusicPlayer player(os, iplayer::TrackLoading::Full, period);
+		REQUIRE(player.openMusic(file));
+
+		player.play();
+		REQUIRE_LE(2, lines.waitFor(2).size());
+		player.pause();
+		const auto pausedAt = player.getPosition();
+		const auto countInPause = lines.waitFor(0, 0ms).size();
+		CHECK_GE(pausedAt, 2 * period);
+		std::this_thread::sleep_for(3 * period);
+		CHECK_EQ(countInPause, lines.waitFor(0, 0ms).size());
+		CHECK_EQ(pausedAt, player.getPosition());
+
+		// Paused: the thread waits without deadline, and is woken up by play (or times out).
+		player.seek(10 * period + period / 2);
+		const auto playedAt = Clock::now();
+		player.play();
+		auto time = lines.waitForLine("Line 10");
+		REQUIRE(time);
+		CHECK_GE(*time, playedAt + period / 2);
+
+		// Playing: a seek moves the deadline being waited for, later or sooner.
+		const auto seekedAt = Clock::now();
+		player.seek(20 * period);
+		time = lines.waitForLine("Line 20");
+		REQUIRE(time);
+		CHECK_GE(*time, seekedAt + period);
+
+		// Woken up at the old deadline instead, the thread would most likely be past line 29.
+		player.seek(30 * period - period / 10);
+		time = lines.waitForLine("Line 29");
+		CHECK(time);
+	}
+	std::filesystem::remove(file);
+}
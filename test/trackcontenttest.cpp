@@ -0,0 +1,71 @@
+#include "newlinescan.h"
+#include "trackcontent.h"
+
+#include <doctest.h>
+#include <fstream>
+#include <random>
+
+//------------------------------------------------------------------------------
+TEST_CASE("findNewlines")
+{
+	std::default_random_engine rng{42};
+	std::string s(1000, ' ');
+	for (auto& c : s) {
+		c = std::uniform_int_distribution<int>{0, 9}(rng) == 0 ? '\n' : 'a';
+	}
+	for (std::size_t offset : {0, 1, 31, 32, 33}) {
+		for (std::size_t size : {0, 1, 31, 32, 63, 64, 65, 900}) {
+			const std::string_view view = std::string_view(s).substr(offset, size);
+			std::vector<std::size_t> expected;
+			for (std::size_t i = 0; i != view.size(); ++i) {
+				if (view[i] == '\n') {
+					expected.push_back(i);
+				}
+			}
+			std::vector<std::size_t> scalar;
+			std::vector<std::size_t> simd;
+			iplayer::findNewlines(view, scalar, false);
+			iplayer::findNewlines(view, simd);
+			CHECK_EQ(expected, scalar);
+			CHECK_EQ(expected, simd);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("openTrackContent agrees with std::getline")
+{
+	const std::filesystem::path file = std::filesystem::temp_directory_path() / "iplayer-test-content";
+	const std::vector<std::string> contents{
+		"\"Header only\" 1",
+		"\"Header only\" 1\n",
+		"\"T\" 3\nA\n\nB",
+		"\"T\" 3\r\nA\r\nB\r\n",
+		"\"T\" 2\n\n\n",
+	};
+	for (const auto& content : contents) {
+		CAPTURE(content);
+		std::ofstream(file, std::ios::binary) << content;
+
+		std::vector<std::string> expected;
+		std::ifstream is(file);
+		for (std::string line; std::getline(is, line);) {
+			expected.push_back(line);
+		}
+		expected.erase(expected.begin()); // header
+
+		for (auto loading : {iplayer::TrackLoading::Full, iplayer::TrackLoading::Streaming}) {
+			auto trackContent = iplayer::openTrackContent(file, loading);
+			REQUIRE(trackContent);
+			std::vector<std::string> lines;
+			for (std::size_t i = 0; const auto line = trackContent->getLine(i); ++i) {
+				lines.emplace_back(*line);
+			}
+			CHECK_EQ(expected, lines);
+		}
+	}
+	std::ofstream(file, std::ios::binary).flush();
+	CHECK_FALSE(iplayer::openTrackContent(file));
+	CHECK_FALSE(iplayer::openTrackContent(file, iplayer::TrackLoading::Streaming));
+	std::filesystem::remove(file);
+}
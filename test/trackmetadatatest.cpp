@@ -0,0 +1,74 @@
+#include "trackmetadata.h"
+
+#include "playlist.h"
+#include "trackheader.h"
+
+#include <doctest.h>
+#include <fstream>
+#include <sstream>
+
+using namespace std::literals;
+
+//------------------------------------------------------------------------------
+TEST_CASE("parseTrackMetadata")
+{
+	const auto metadata =
+		iplayer::parseTrackMetadata(R"( album="Some \"album\"" artist=Someone year="1999"  codec="flac" )");
+
+	CHECK_EQ("Some \"album\"", metadata.album);
+	CHECK_EQ("Someone", metadata.artist);
+	CHECK_EQ("flac", metadata.codec);
+	CHECK_EQ(std::vector<std::pair<std::string, std::string>>{{"year", "1999"}}, metadata.others);
+
+	CHECK_EQ(iplayer::TrackMetadata{}, iplayer::parseTrackMetadata(""));
+	CHECK_EQ("a", iplayer::parseTrackMetadata(R"(album=a artist="unterminated)").album);
+	CHECK(iplayer::parseTrackMetadata(R"(garbage album=a)").album.empty());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("TrackMetadataCache")
+{
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path() / "iplayer-test-metadata";
+	std::filesystem::create_directories(tmpDir);
+	std::vector<std::filesystem::path> files;
+	for (std::size_t i = 0; i != 3; ++i) {
+		files.push_back(tmpDir / ("track" + std::to_string(i)));
+		std::ofstream(files.back()) << "\"Title\" 4 album=\"Album" << i << "\"\nline\n";
+	}
+	iplayer::TrackMetadataCache cache(2);
+
+	CHECK_EQ("Album0", cache.get(files[0])->album);
+	CHECK_EQ("Album1", cache.get(files[1])->album);
+	CHECK_EQ(cache.get(files[0]), cache.get(files[0])); // file1 is now the least recently used
+	CHECK_EQ("Album2", cache.get(files[2])->album);
+	CHECK_EQ(2, cache.size());
+
+	std::ofstream(files[0]) << "\"Title\" 4 album=\"Changed\"\n";
+	CHECK_EQ("Album0", cache.get(files[0])->album);
+	cache.invalidate(files[0]);
+	CHECK_EQ("Changed", cache.get(files[0])->album);
+
+	CHECK_EQ(iplayer::TrackMetadata{}, *cache.get(tmpDir / "not-exist"));
+
+	// Eager fields are unaffected, and the parser stops before the metadata.
+	CHECK_EQ("Title", iplayer::openTrackHeader(files[1]).title);
+
+	std::filesystem::remove_all(tmpDir);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Metadata are not loaded by comparisons")
+{
+	auto& cache = iplayer::TrackMetadataCache::global();
+	const auto initialSize = cache.size();
+	iplayer::Playlist playlist;
+	for (int i = 0; i != 10; ++i) {
+		playlist.push_back(
+			iplayer::TrackHeader{.filename = "file" + std::to_string(i % 3), .title = "Title", .duration = 1s});
+	}
+
+	playlist.removeDuplicate();
+	CHECK_EQ(3, playlist.getTracks().size());
+	CHECK_EQ(*playlist.getTracks()[0].second, *playlist.getTracks()[0].second);
+	CHECK_EQ(initialSize, cache.size());
+}
@@ -0,0 +1,38 @@
+#include "trackstore.h"
+
+#include "testutils.h"
+
+#include <doctest.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("TrackStore::intern")
+{
+	iplayer::TrackStore store;
+
+	auto track1 = store.intern(makeTrack(1));
+	auto track1bis = store.intern(makeTrack(1));
+	auto track2 = store.intern(makeTrack(2));
+
+	CHECK_EQ(track1, track1bis);
+	CHECK_NE(track1, track2);
+	CHECK_EQ(makeTrack(1), *track1);
+	CHECK_EQ(2, store.size());
+
+	auto renamed = makeTrack(1);
+	renamed.title = "Other title";
+	CHECK_NE(track1, store.intern(std::move(renamed))); // same file, different header
+
+	track1.reset();
+	track1bis.reset();
+	CHECK_EQ(1, store.size());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("TrackStore shared by playlists")
+{
+	auto playlist1 = buildPlaylist({0, 1, 2});
+	auto playlist2 = buildPlaylist({2, 1, 0});
+
+	CHECK_EQ(playlist1.getTracks()[0].second, playlist2.getTracks()[2].second);
+	CHECK_EQ(playlist1.getTracks()[1].second, playlist2.getTracks()[1].second);
+}
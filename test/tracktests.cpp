@@ -1,7 +1,10 @@
 #include "trackheader.h"
 
 #include <doctest.h>
+#include <fstream>
+#include <optional>
 #include <sstream>
+#include <vector>
 
 using namespace std::literals;
 
@@ -42,7 +45,120 @@ TEST_CASE("data")
 	CHECK_NOTHROW(iplayer::openTrackHeader(dataDir / "track3"));
 	CHECK_NOTHROW(iplayer::openTrackHeader(dataDir / "track4"));
 
-	CHECK_THROWS(iplayer::openTrackHeader(dataDir / "not-exist"));
-	CHECK_THROWS(iplayer::openTrackHeader(dataDir / "invalid1"));
-	CHECK_THROWS(iplayer::openTrackHeader(dataDir / "invalid2"));
+	CHECK_THROWS_AS(iplayer::openTrackHeader(dataDir / "not-exist"), iplayer::TrackHeaderException);
+	CHECK_THROWS_AS(iplayer::openTrackHeader(dataDir / "invalid1"), iplayer::TrackHeaderException);
+	CHECK_THROWS_AS(iplayer::openTrackHeader(dataDir / "invalid2"), iplayer::TrackHeaderException);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("InternedPath")
+{
+	const iplayer::InternedPath p1 = std::filesystem::path("some/long/directory/track1");
+	const iplayer::InternedPath p2 = "some/long/directory/track2";
+	const iplayer::InternedPath p1bis = std::string("some/long/directory/track1");
+
+	CHECK_EQ(p1, p1bis);
+	CHECK_NE(p1, p2);
+	CHECK_EQ(p1.hash(), p1bis.hash());
+	CHECK_EQ(std::filesystem::path("some/long/directory/track2"), p2.path());
+	CHECK_EQ(std::filesystem::path("track2"), p2.filename());
+	CHECK(iplayer::InternedPath().empty());
+	CHECK_LT(sizeof(iplayer::InternedPath), sizeof(std::filesystem::path));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("readTrackHeader agrees with stream parser")
+{
+	// working dir is at solution/$buildsystem/
+	const std::filesystem::path dataDir = "../../data";
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path() / "iplayer-test";
+	std::filesystem::create_directories(tmpDir);
+	const std::vector<std::string> headers{
+		"\"Escaped \\\" quote\" 12\n",
+		"\"Unterminated 12\n",
+		"Unquoted 7 trailing\r\n",
+		"  \"Spaces\"   +5",
+		"\"Bad sign\" +-5\n",
+		"\"No duration\"\n",
+		"\"Overflow\" 99999999999999999999\n",
+		"\"Negative\" -3\n",
+		"\"Long " + std::string(1000, 'x') + "\" 8\n",
+		"\n",
+	};
+	std::vector<std::filesystem::path> files;
+	for (std::size_t i = 0; i != headers.size(); ++i) {
+		files.push_back(tmpDir / ("header" + std::to_string(i)));
+		std::ofstream(files.back(), std::ios::binary) << headers[i];
+	}
+	for (const auto& entry : std::filesystem::directory_iterator(dataDir)) {
+		files.push_back(entry.path());
+	}
+	files.push_back(dataDir / "not-exist");
+
+	for (const auto& file : files) {
+		CAPTURE(file);
+		std::optional<iplayer::TrackHeader> expected;
+		if (std::ifstream is(file); is) {
+			try {
+				expected = iplayer::openTrackHeader(file, is);
+			}
+			catch (const std::exception&) {
+			}
+		}
+		iplayer::TrackHeader track;
+		const bool ok = iplayer::readTrackHeader(file, track);
+
+		REQUIRE_EQ(expected.has_value(), ok);
+		if (ok) {
+			CHECK_EQ(*expected, track);
+		}
+	}
+	std::filesystem::remove_all(tmpDir);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("tryOpenTrackHeaders")
+{
+	using Code = iplayer::TrackHeaderError::Code;
+	// working dir is at solution/$buildsystem/
+	const std::filesystem::path dataDir = "../../data";
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path() / "iplayer-test-errors";
+	std::filesystem::create_directories(tmpDir);
+	const std::vector<std::pair<std::string, iplayer::TrackHeaderError>> invalidHeaders{
+		{"  \n", {Code::Empty, 2}},
+		{"  \"Unterminated 12\n", {Code::BadQuoting, 2}},
+		{"\"Trailing backslash\\", {Code::BadQuoting, 0}},
+		{"\"Bad sign\"  +-5\n", {Code::BadDuration, 12}},
+		{"Unquoted\n", {Code::BadDuration, 8}},
+	};
+	std::vector<std::filesystem::path> files{dataDir / "track1", dataDir / "not-exist", dataDir / "invalid1"};
+	for (std::size_t i = 0; i != invalidHeaders.size(); ++i) {
+		files.push_back(tmpDir / ("header" + std::to_string(i)));
+		std::ofstream(files.back(), std::ios::binary) << invalidHeaders[i].first;
+	}
+
+	const auto results = iplayer::tryOpenTrackHeaders(files);
+
+	REQUIRE_EQ(files.size(), results.size());
+	REQUIRE(results[0].has_value());
+	CHECK_EQ(iplayer::openTrackHeader(files[0]), *results[0]);
+	REQUIRE_FALSE(results[1].has_value());
+	CHECK_EQ(iplayer::TrackHeaderError{Code::NotFound, 0}, results[1].error());
+	REQUIRE_FALSE(results[2].has_value());
+	CHECK_EQ(iplayer::TrackHeaderError{Code::Empty, 0}, results[2].error());
+	for (std::size_t i = 0; i != invalidHeaders.size(); ++i) {
+		CAPTURE(invalidHeaders[i].first);
+		REQUIRE_FALSE(results[3 + i].has_value());
+		CHECK_EQ(invalidHeaders[i].second, results[3 + i].error());
+	}
+
+	try {
+		iplayer::openTrackHeader(files[6]);
+		FAIL("should throw");
+	}
+	catch (const iplayer::TrackHeaderException& ex) {
+		CHECK_EQ(invalidHeaders[3].second, ex.getError());
+		CHECK_EQ("Invalid format: Bad duration at offset 12"s, ex.what());
+	}
+	std::filesystem::remove_all(tmpDir);
 }
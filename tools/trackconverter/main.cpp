@@ -0,0 +1,24 @@
+#include "binarytrack.h"
+
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+	auto format = iplayer::TrackFormat::Binary;
+	int first = 1;
+	if (argc > 1 && std::strcmp(argv[1], "--text") == 0) {
+		format = iplayer::TrackFormat::Text;
+		++first;
+	}
+	if (argc - first != 2) {
+		std::cerr << "Usage: " << argv[0] << " [--text] $input $output\n"
+		          << "Convert a track file to the binary format (or back to text with --text).\n";
+		return 1;
+	}
+	if (!iplayer::convertTrack(argv[first], argv[first + 1], format)) {
+		std::cerr << "Cannot convert " << argv[first] << "\n";
+		return 1;
+	}
+	return 0;
+}